@@ -16,15 +16,95 @@
 //
 //===----------------------------------------------------------------===//
 
-#include <Parser.hpp>
+#include <Annotate.hpp>
+#include <NtCode.hpp>
+#include <Search.hpp>
+#include <Watch.hpp>
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/WithColor.h"
+#include "llvm/Support/xxhash.h"
+#include <chrono>
 
 using namespace llvm;
 
+static cl::opt<std::string> InputName(cl::Positional,
+  cl::desc("<input html>"));
+static cl::opt<std::string> OutputName(cl::Positional,
+  cl::desc("<output>"));
+
+static cl::opt<size_t> LargeGroupSize("large-group-size",
+  cl::desc("Groups larger than this are split by facility "
+    "(default: none are)"),
+  cl::init(size_t(-1)));
+static cl::opt<EmitStrategy> StrategyOverride("strategy",
+  cl::desc("Lookup strategy for every emitted table"),
+  cl::init(EmitStrategy::Auto),
+  cl::values(
+    clEnumValN(EmitStrategy::Auto,   "auto",   "Pick using the cost model"),
+    clEnumValN(EmitStrategy::Switch, "switch", "One case per code"),
+    clEnumValN(EmitStrategy::Dense,  "dense",  "Index array over the code span"),
+    clEnumValN(EmitStrategy::Sorted, "sorted", "Binary searched key array"),
+    clEnumValN(EmitStrategy::Hashed, "hashed", "Open addressed hash table")));
+static cl::opt<EmitMode> Mode("mode",
+  cl::desc("Shape of the generated source"),
+  cl::init(EmitMode::Code),
+  cl::values(
+    clEnumValN(EmitMode::Code, "code", "A table and lookup per group"),
+    clEnumValN(EmitMode::Data, "data", "Plain arrays and one shared lookup"),
+    clEnumValN(EmitMode::Split, "split",
+      "Like data, with messages in a cold section")));
+static cl::opt<std::string> ProfileName("profile",
+  cl::desc("Lookup counts used to put hot entries first"),
+  cl::value_desc("filename"));
+static cl::opt<bool> EmitRegistry("emit-registry",
+  cl::desc("Allow registering extra facilities at runtime "
+    "(their tables are referenced, not copied)"));
+static cl::opt<unsigned> Threads("j",
+  cl::desc("Threads used for emission, annotation and batches "
+    "(0 uses every core)"),
+  cl::init(0));
+static cl::opt<ReportFormat> Report("report",
+  cl::desc("Print the estimated size of each generated table"),
+  cl::init(ReportFormat::None),
+  cl::values(
+    clEnumValN(ReportFormat::None,  "none",  "No report"),
+    clEnumValN(ReportFormat::Table, "table", "Sorted plain text table"),
+    clEnumValN(ReportFormat::JSON,  "json",  "JSON array")));
+static cl::opt<std::string> ReportOutput("report-output",
+  cl::desc("Write the report here instead of stdout"),
+  cl::value_desc("filename"));
+static cl::opt<bool> Watch("watch",
+  cl::desc("Regenerate the output whenever the input changes"));
+static cl::opt<bool> EmitIndex("emit-index",
+  cl::desc("Write a trigram search index next to the output"));
+static cl::opt<std::string> Find("find",
+  cl::desc("Print the entries whose name or message contains <text>"),
+  cl::value_desc("text"));
+static cl::opt<std::string> Fuzzy("fuzzy",
+  cl::desc("Print the entries closest to <text>, best first"),
+  cl::value_desc("text"));
+static cl::opt<unsigned> MaxResults("max-results",
+  cl::desc("Most search results to print (0 prints all)"),
+  cl::init(10));
+static cl::opt<std::string> Annotate("annotate",
+  cl::desc("Write <log> to the output with each known status code "
+    "followed by its name ('-' reads stdin)"),
+  cl::value_desc("log"));
+static cl::opt<bool> AnnotateMessages("annotate-messages",
+  cl::desc("Add the message after the name when annotating"));
+static cl::opt<std::string> Batch("batch",
+  cl::desc("Convert every `<input html> <output>` pair listed in <file>, "
+    "instead of the positional ones"),
+  cl::value_desc("file"));
+
 [[noreturn]] static void exitWithError(
  Twine Msg, std::string Hint = "") {
   errs() << raw_ostream::RED << Msg 
@@ -56,17 +136,237 @@ static std::pair<bool, SmallString<128>>
   return {false, SmallString<128>{}};
 }
 
+static HitProfile loadProfile(StringRef Filename) {
+  auto EMBuffer = MemoryBuffer::getFile(Filename, true);
+  if (auto EC = EMBuffer.getError())
+    exitWithError("Could not open " + Filename + ": " + EC.message());
+  auto EProfile = HitProfile::parse((*EMBuffer)->getMemBufferRef());
+  if (!EProfile)
+    exitWithError(EProfile.takeError());
+  return std::move(*EProfile);
+}
+
+static ParserOptions getParserOptions() {
+  ParserOptions Opts;
+  Opts.LargeGroupSize = LargeGroupSize;
+  Opts.StrategyOverride = StrategyOverride;
+  Opts.EmitRegistry = EmitRegistry;
+  Opts.Mode = Mode;
+  Opts.EmitThreads = Threads;
+  if (!ProfileName.empty())
+    Opts.setHitProfile(loadProfile(ProfileName));
+  return Opts;
+}
+
+static SmallString<128> getIndexPath() {
+  SmallString<128> IndexPath = StringRef(OutputName);
+  sys::path::replace_extension(IndexPath, "trigrams");
+  return IndexPath;
+}
+
+static Error writeIndex(const ntcode::Catalog& Catalog,
+ const MemoryBuffer& MB) {
+  auto Index = ntcode::TrigramIndex::build(Catalog,
+    xxHash64(MB.getBuffer()));
+  return Index.writeToFile(getIndexPath());
+}
+
+/// Loads the index next to the output, if it was built from this input.
+static std::optional<ntcode::TrigramIndex> loadIndex(uint64_t InputHash) {
+  const SmallString<128> IndexPath = getIndexPath();
+  auto EMBuffer = MemoryBuffer::getFile(IndexPath);
+  if (!EMBuffer)
+    return std::nullopt;
+  auto EIndex = ntcode::TrigramIndex::load((*EMBuffer)->getMemBufferRef());
+  if (!EIndex) {
+    WithColor::warning() << IndexPath << ": "
+      << toString(EIndex.takeError()) << "\n";
+    return std::nullopt;
+  }
+  if (EIndex->getInputHash() != InputHash)
+    return std::nullopt;
+  return std::move(*EIndex);
+}
+
+static void printHits(ArrayRef<ntcode::SearchHit> Hits, bool ShowScore) {
+  if (Hits.empty()) {
+    outs() << "No matches.\n";
+    return;
+  }
+  for (const ntcode::SearchHit& Hit : Hits) {
+    if (ShowScore)
+      outs() << format("[%.2f] ", Hit.Score);
+    outs() << format_hex(Hit.ID, 10, true) << ' '
+      << Hit.Name << ": " << Hit.Message << '\n';
+  }
+}
+
+/// Answers `-find` and `-fuzzy`, using the saved index when it's current.
+static void search(const MemoryBuffer& MB) {
+  const uint64_t InputHash = xxHash64(MB.getBuffer());
+  auto Index = loadIndex(InputHash);
+  if (!Index) {
+    auto ECatalog = ntcode::Catalog::parse(MB.getMemBufferRef());
+    if (!ECatalog)
+      exitWithError(ECatalog.takeError());
+    Index = ntcode::TrigramIndex::build(*ECatalog, InputHash);
+    if (EmitIndex) {
+      if (Error E = Index->writeToFile(getIndexPath()))
+        exitWithError(std::move(E));
+    }
+  }
+
+  if (!Find.empty())
+    printHits(Index->find(Find, MaxResults), false);
+  if (!Fuzzy.empty())
+    printHits(Index->fuzzy(Fuzzy, MaxResults), true);
+}
+
+/// Answers `-annotate`, writing the annotated log to the output.
+static void annotate(const MemoryBuffer& MB) {
+  auto ECatalog = ntcode::Catalog::parse(MB.getMemBufferRef());
+  if (!ECatalog)
+    exitWithError(ECatalog.takeError());
+  const ntcode::LogAnnotator Annotator(*ECatalog, AnnotateMessages);
+
+  sys::fs::file_t In = sys::fs::getStdinHandle();
+  if (Annotate != "-") {
+    auto EIn = sys::fs::openNativeFileForRead(Annotate);
+    if (!EIn) {
+      exitWithError("Could not open " + Annotate + ": "
+        + toString(EIn.takeError()));
+    }
+    In = *EIn;
+  }
+  auto CloseIn = make_scope_exit([&In] {
+    if (In != sys::fs::getStdinHandle())
+      sys::fs::closeFile(In);
+  });
+
+  std::error_code EC;
+  raw_fd_ostream OS(OutputName, EC);
+  if (EC)
+    exitWithErrorCode(EC);
+  if (Error E = Annotator.annotateFile(In, OS, Threads))
+    exitWithError(std::move(E));
+  OS.close();
+  if (OS.has_error())
+    exitWithErrorCode(OS.error());
+}
+
+/// Answers `-batch`, converting the listed pairs concurrently. Errors
+/// are printed in list order once every conversion is done.
+static int convertBatch(StringRef ListName) {
+  struct Job {
+    StringRef Input, Output;
+    std::string Error;
+  };
+  auto EMBuffer = MemoryBuffer::getFile(ListName, true);
+  if (auto EC = EMBuffer.getError())
+    exitWithError("Could not open " + ListName + ": " + EC.message());
+
+  SmallVector<Job, 0> Jobs;
+  SmallVector<StringRef, 0> Lines;
+  (*EMBuffer)->getBuffer().split(Lines, '\n');
+  for (size_t Ix = 0; Ix < Lines.size(); ++Ix) {
+    const StringRef Line = Lines[Ix].trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+    SmallVector<StringRef, 2> Fields;
+    SplitString(Line, Fields);
+    if (Fields.size() != 2) {
+      exitWithError(ListName + ":" + Twine(Ix + 1)
+        + ": expected `<input html> <output>`.");
+    }
+    Jobs.push_back({.Input = Fields[0], .Output = Fields[1], .Error = {}});
+  }
+
+  // Files are the unit of work, so each one is emitted on one thread.
+  ParserOptions Opts = getParserOptions();
+  Opts.EmitThreads = 1;
+  auto Convert = [&Opts] (Job& J) {
+    auto EInput = MemoryBuffer::getFile(J.Input, true);
+    if (auto EC = EInput.getError()) {
+      J.Error = ("Could not open " + J.Input + ": " + EC.message()).str();
+      return;
+    }
+    auto ECatalog = ntcode::Catalog::parse(
+      (*EInput)->getMemBufferRef(), Opts);
+    Error E = ECatalog ? ECatalog->writeToFile(J.Output)
+      : ECatalog.takeError();
+    if (E)
+      J.Error = toString(std::move(E));
+  };
+
+  ThreadPool Pool(hardware_concurrency(Threads));
+  for (Job& J : Jobs)
+    Pool.async([&Convert, &J] { Convert(J); });
+  Pool.wait();
+
+  size_t Failed = 0;
+  for (const Job& J : Jobs) {
+    if (J.Error.empty())
+      continue;
+    WithColor::error() << J.Error << "\n";
+    ++Failed;
+  }
+  outs() << "Converted " << (Jobs.size() - Failed) << " of "
+    << Jobs.size() << " files.\n";
+  return Failed ? 1 : 0;
+}
+
+/// Re-parses `InputPath` into `Catalog` and rewrites the output.
+/// Errors are reported, but don't stop the watch.
+static bool regenerate(ntcode::Catalog& Catalog, StringRef InputPath,
+ std::unique_ptr<MemoryBuffer>& MB) {
+  using Clock = std::chrono::steady_clock;
+  const auto Start = Clock::now();
+  auto EMBuffer = MemoryBuffer::getFile(InputPath, true);
+  if (auto EC = EMBuffer.getError()) {
+    WithColor::error() << "Could not open " << InputPath
+      << ": " << EC.message() << "\n";
+    return true;
+  }
+
+  // The catalog refers into the new buffer from here on.
+  Error E = Catalog.reparse((*EMBuffer)->getMemBufferRef());
+  MB = std::move(*EMBuffer);
+  if (!E)
+    E = Catalog.writeToFile(OutputName);
+  if (!E && EmitIndex)
+    E = writeIndex(Catalog, *MB);
+  if (E) {
+    WithColor::error() << toString(std::move(E)) << "\n";
+    return true;
+  }
+
+  const NtCodeParser& Parser = Catalog.getParser();
+  auto [Parsed, Reused] = Parser.getRowStats();
+  const auto Elapsed = std::chrono::duration_cast<
+    std::chrono::microseconds>(Clock::now() - Start);
+  outs() << "Regenerated in " << format("%.2f", Elapsed.count() / 1000.0)
+    << "ms (rows parsed: " << Parsed << ", reused: " << Reused
+    << "; groups emitted: {" << join(Parser.getLastEmitted(), ", ")
+    << "}).\n";
+  outs().flush();
+  return true;
+}
+
 int main(int N, char *Argv[]) {
-  if (N < 3) {
-    exitWithError(
-      "Not enough arguments!", 
-      "Required: 2");
+  cl::ParseCommandLineOptions(N, Argv, "NTSTATUS table generator\n");
+  if (!Batch.empty()) {
+    if (!InputName.empty() || !OutputName.empty())
+      exitWithError("-batch takes its inputs and outputs from the list.");
+    return convertBatch(Batch);
+  }
+  if (InputName.empty() || OutputName.empty()) {
+    exitWithError("Expected an <input html> and an <output>.",
+      "Use -batch=<file> to convert several at once.");
   }
 
   bool Found = false;
   SmallString<128> InputPath;
-  StringRef OutputName = Argv[2];
-  std::tie(Found, InputPath) = resolveFilePath(Argv[1]);
+  std::tie(Found, InputPath) = resolveFilePath(InputName);
 
   if (!Found) {
     StringRef Filename(InputPath);
@@ -81,11 +381,48 @@ int main(int N, char *Argv[]) {
   }
   
   std::unique_ptr<MemoryBuffer> &MB = *EMBuffer;
-  NtCodeParser Parser(MB->getMemBufferRef());
-  Parser.SetLargeGroupSize(-1);
-  if (!Parser.parseFile())
-    exitWithError("Parsing failed.");
-  Parser.dumpGroups();
-  if (!Parser.writeToFile(OutputName))
-    exitWithError("Writing failed.");
+  if (!Find.empty() || !Fuzzy.empty()) {
+    search(*MB);
+    return 0;
+  }
+  if (!Annotate.empty()) {
+    annotate(*MB);
+    return 0;
+  }
+
+  auto ECatalog = ntcode::Catalog::parse(MB->getMemBufferRef(),
+    getParserOptions());
+  if (!ECatalog)
+    exitWithError(ECatalog.takeError());
+  const NtCodeParser& Parser = ECatalog->getParser();
+  // A JSON report on stdout has to be the only thing there.
+  const bool QuietDumps = (Report == ReportFormat::JSON)
+    && ReportOutput.empty();
+  if (!QuietDumps)
+    Parser.dumpGroups();
+  if (Error E = ECatalog->writeToFile(OutputName))
+    exitWithError(std::move(E));
+  if (EmitIndex) {
+    if (Error E = writeIndex(*ECatalog, *MB))
+      exitWithError(std::move(E));
+  }
+  if (!QuietDumps)
+    Parser.dumpStrategies();
+  if (ReportOutput.empty()) {
+    Parser.dumpFootprint(outs(), Report);
+  } else {
+    std::error_code EC;
+    raw_fd_ostream ReportOS(ReportOutput, EC, sys::fs::OF_Text);
+    if (EC)
+      exitWithErrorCode(EC);
+    Parser.dumpFootprint(ReportOS, Report);
+  }
+
+  if (Watch) {
+    outs() << "Watching \"" << InputPath << "\"...\n";
+    outs().flush();
+    if (Error E = ntcode::WatchFile(InputPath,
+     [&] { return regenerate(*ECatalog, InputPath, MB); }))
+      exitWithError(std::move(E));
+  }
 }
@@ -0,0 +1,135 @@
+//===- CompileBench.cpp ---------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Compiles generated sources a few times each and compares what they
+// cost downstream: wall time, CPU time and the compiler's peak memory.
+// The first source is the baseline whose CPU time the others are
+// compared to.
+//
+//===----------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/WithColor.h"
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+using namespace llvm;
+
+static cl::opt<std::string> Compiler("cxx",
+  cl::desc("Compiler to run"), cl::value_desc("path"), cl::Required);
+static cl::list<std::string> CompilerFlags("cxx-flag",
+  cl::desc("Flag passed to every compile"), cl::value_desc("flag"));
+static cl::opt<unsigned> Runs("runs",
+  cl::desc("Compiles per source, the best one is kept"),
+  cl::init(3));
+static cl::list<std::string> Sources(cl::Positional, cl::OneOrMore,
+  cl::desc("<name>=<source>..."));
+
+namespace {
+struct Sample {
+  double WallSec = 0.0;
+  double CPUSec = 0.0;
+  uint64_t PeakKiB = 0;
+};
+} // namespace `anonymous`
+
+static Sample Compile(StringRef Source);
+static Sample CompileOnce(StringRef Source);
+
+int main(int N, char* Argv[]) {
+  cl::ParseCommandLineOptions(N, Argv,
+    "Compile-time benchmark for generated sources\n");
+  if (Runs == 0)
+    Runs = 1;
+
+  outs() << "Mode           Size KiB     Wall s      CPU s   Peak MiB"
+    "    vs base\n";
+  std::optional<Sample> Base;
+  for (StringRef Pair : Sources) {
+    auto [Name, Source] = Pair.split('=');
+    if (Source.empty()) {
+      WithColor::error() << "Expected <name>=<source>, got "
+        << Pair << ".\n";
+      return 2;
+    }
+    uint64_t Size = 0;
+    if (auto EC = sys::fs::file_size(Source, Size)) {
+      WithColor::error() << "Could not open " << Source
+        << ": " << EC.message() << "\n";
+      return 2;
+    }
+
+    const Sample S = Compile(Source);
+    if (!Base)
+      Base = S;
+    outs() << format("%-12s %10.1f %10.3f %10.3f %10.1f %9.2fx\n",
+      Name.str().c_str(), Size / 1024.0, S.WallSec, S.CPUSec,
+      S.PeakKiB / 1024.0, S.CPUSec / std::max(Base->CPUSec, 1e-6));
+  }
+  return 0;
+}
+
+//=== Statics ===//
+
+Sample Compile(StringRef Source) {
+  // Each figure is the best over the runs, so a busy machine only
+  // makes the comparison noisier, not one-sided.
+  Sample Best = CompileOnce(Source);
+  for (unsigned Run = 1; Run < Runs; ++Run) {
+    const Sample S = CompileOnce(Source);
+    Best.WallSec = std::min(Best.WallSec, S.WallSec);
+    Best.CPUSec = std::min(Best.CPUSec, S.CPUSec);
+    Best.PeakKiB = std::min(Best.PeakKiB, S.PeakKiB);
+  }
+  return Best;
+}
+
+Sample CompileOnce(StringRef Source) {
+  SmallVector<StringRef, 16> Args {Compiler};
+  for (const std::string& Flag : CompilerFlags)
+    Args.push_back(Flag);
+  Args.append({"-c", Source, "-o", "/dev/null"});
+
+  using Clock = std::chrono::steady_clock;
+  std::string ErrMsg;
+  Optional<sys::ProcessStatistics> Stats;
+  const auto Start = Clock::now();
+  const int Result = sys::ExecuteAndWait(Compiler, Args, None, {},
+    0, 0, &ErrMsg, nullptr, &Stats);
+  const std::chrono::duration<double> Wall = Clock::now() - Start;
+  if (Result != 0) {
+    WithColor::error() << Compiler << " failed on " << Source;
+    if (!ErrMsg.empty())
+      errs() << ": " << ErrMsg;
+    errs() << ".\n";
+    std::exit(1);
+  }
+
+  Sample S;
+  S.WallSec = Wall.count();
+  if (Stats) {
+    S.CPUSec = Stats->TotalTime.count() / 1e6;
+    S.PeakKiB = Stats->PeakMemory;
+  }
+  return S;
+}
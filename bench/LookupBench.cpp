@@ -0,0 +1,163 @@
+//===- LookupBench.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Linked with one generated source, and times its lookups on a skewed
+// workload: most IDs are drawn by their hits in a profile, the rest
+// uniformly from the catalog. The same seed gives the same IDs, so
+// builds with and without `-profile` can be compared.
+//
+//===----------------------------------------------------------------===//
+
+#include <Sys/OpaqueError.hpp>
+#include "NtCode.hpp"
+#include "Profile.hpp"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/WithColor.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+using namespace hc::sys;
+
+static cl::opt<std::string> InputName(cl::Positional, cl::Required,
+  cl::desc("<input html>"));
+static cl::opt<std::string> ProfileName(cl::Positional, cl::Required,
+  cl::desc("<profile>"));
+static cl::opt<std::string> Label("label",
+  cl::desc("Name printed with the results"), cl::init("lookup"));
+static cl::opt<unsigned> Runs("runs",
+  cl::desc("Passes over the workload, the best one is kept"),
+  cl::init(5));
+static cl::opt<unsigned> Lookups("lookups",
+  cl::desc("IDs in the workload"), cl::init(1u << 20));
+static cl::opt<unsigned> HotPercent("hot-percent",
+  cl::desc("Share of the IDs drawn from the profile"), cl::init(90));
+
+static std::unique_ptr<MemoryBuffer> ReadFile(StringRef Filename);
+static std::vector<OpqErrorID> MakeWorkload(const ntcode::Catalog& C,
+  const HitProfile& Profile);
+static double TimeSingle(ArrayRef<OpqErrorID> IDs, uintptr_t& Sink);
+static double TimeBatch(ArrayRef<OpqErrorID> IDs, uintptr_t& Sink);
+
+int main(int N, char* Argv[]) {
+  cl::ParseCommandLineOptions(N, Argv,
+    "Lookup benchmark for a generated source\n");
+  const auto Input = ReadFile(InputName);
+  const auto ProfileMB = ReadFile(ProfileName);
+  auto ECatalog = ntcode::Catalog::parse(Input->getMemBufferRef());
+  if (!ECatalog) {
+    WithColor::error() << toString(ECatalog.takeError()) << "\n";
+    return 2;
+  }
+  auto EProfile = HitProfile::parse(ProfileMB->getMemBufferRef());
+  if (!EProfile) {
+    WithColor::error() << toString(EProfile.takeError()) << "\n";
+    return 2;
+  }
+
+  const std::vector<OpqErrorID> IDs = MakeWorkload(*ECatalog, *EProfile);
+  if (IDs.empty()) {
+    WithColor::error() << "The catalog has no entries.\n";
+    return 2;
+  }
+  // Folding in every result keeps the lookups from being dropped.
+  uintptr_t Sink = 0;
+  double Single = TimeSingle(IDs, Sink);
+  double Batch = TimeBatch(IDs, Sink);
+  for (unsigned Run = 1; Run < Runs; ++Run) {
+    Single = std::min(Single, TimeSingle(IDs, Sink));
+    Batch = std::min(Batch, TimeBatch(IDs, Sink));
+  }
+
+  const double PerLookup = 1e9 / IDs.size();
+  outs() << format("%-12s single %7.2f ns/lookup, batch %7.2f ns/lookup"
+    " (checksum %zx)\n", Label.c_str(), Single * PerLookup,
+    Batch * PerLookup, size_t(Sink));
+  return 0;
+}
+
+//=== Statics ===//
+
+std::unique_ptr<MemoryBuffer> ReadFile(StringRef Filename) {
+  auto EMBuffer = MemoryBuffer::getFile(Filename, true);
+  if (!EMBuffer) {
+    WithColor::error() << "Could not open " << Filename << ".\n";
+    exit(2);
+  }
+  return std::move(*EMBuffer);
+}
+
+std::vector<OpqErrorID> MakeWorkload(const ntcode::Catalog& C,
+ const HitProfile& Profile) {
+  using enum StatusGroup;
+  std::vector<OpqErrorID> All;
+  std::vector<OpqErrorID> Hot;
+  std::vector<double> Weights;
+  for (StatusGroup G : {SUCCESS, INFO, WARNING, ERROR}) {
+    const StatusSpan Statuses = C.getGroup(G);
+    for (size_t Ix = 0; Ix < Statuses.size(); ++Ix) {
+      const OpqErrorID ID = (uint32_t(G) << (7 * 4)) | Statuses.keys()[Ix];
+      All.push_back(ID);
+      if (uint64_t Hits = Profile.lookup(ID, Statuses[Ix].Name)) {
+        Hot.push_back(ID);
+        Weights.push_back(double(Hits));
+      }
+    }
+  }
+  if (All.empty())
+    return {};
+
+  std::mt19937 Rng(0x5EED);
+  std::uniform_int_distribution<size_t> AnyEntry(0, All.size() - 1);
+  std::uniform_int_distribution<unsigned> Percent(0, 99);
+  std::discrete_distribution<size_t> HotEntry(Weights.begin(), Weights.end());
+  std::vector<OpqErrorID> IDs(Lookups);
+  for (OpqErrorID& ID : IDs) {
+    if (!Hot.empty() && Percent(Rng) < HotPercent)
+      ID = Hot[HotEntry(Rng)];
+    else
+      ID = All[AnyEntry(Rng)];
+  }
+  return IDs;
+}
+
+double TimeSingle(ArrayRef<OpqErrorID> IDs, uintptr_t& Sink) {
+  using Clock = std::chrono::steady_clock;
+  const auto Start = Clock::now();
+  uintptr_t Sum = 0;
+  for (OpqErrorID ID : IDs)
+    Sum += reinterpret_cast<uintptr_t>(SysErr::GetOpaqueError(ID));
+  const std::chrono::duration<double> Elapsed = Clock::now() - Start;
+  Sink += Sum;
+  return Elapsed.count();
+}
+
+double TimeBatch(ArrayRef<OpqErrorID> IDs, uintptr_t& Sink) {
+  static std::vector<OpaqueError> Out;
+  Out.assign(IDs.size(), nullptr);
+  using Clock = std::chrono::steady_clock;
+  const auto Start = Clock::now();
+  SysErr::GetOpaqueErrorBatch(IDs, Out);
+  const std::chrono::duration<double> Elapsed = Clock::now() - Start;
+  for (OpaqueError Err : Out)
+    Sink += reinterpret_cast<uintptr_t>(Err);
+  return Elapsed.count();
+}
@@ -0,0 +1,14 @@
+# Runs the parser for one generated source, keeping its dumps out of the
+# build log. Arguments in ARGS are separated by `|`.
+#   cmake -DPARSER=<exe> -DINPUT=<html> -DOUTPUT=<base> -DARGS=<args>
+#     -P Generate.cmake
+string(REPLACE "|" ";" ParserArgs "${ARGS}")
+execute_process(
+  COMMAND ${PARSER} ${INPUT} ${OUTPUT} ${ParserArgs}
+  OUTPUT_FILE ${OUTPUT}.log
+  ERROR_VARIABLE Errors
+  RESULT_VARIABLE Result
+)
+if(NOT Result EQUAL 0)
+  message(FATAL_ERROR "${PARSER} failed on ${INPUT}:\n${Errors}")
+endif()
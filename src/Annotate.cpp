@@ -0,0 +1,205 @@
+//===- Annotate.cpp -------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "Annotate.hpp"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/ThreadPool.h"
+#include <deque>
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+using namespace llvm;
+using namespace ntcode;
+
+/// Bytes read per chunk, before it's cut back to the last full line.
+static constexpr size_t ChunkSize = size_t(4) << 20;
+
+static bool IsWordChar(char C);
+
+LogAnnotator::LogAnnotator(const Catalog& C, bool WithMessages) {
+  using enum StatusGroup;
+  for (StatusGroup G : {SUCCESS, INFO, WARNING, ERROR}) {
+    GroupTable& Table = groups[uint32_t(G) >> 2];
+    const StatusSpan Statuses = C.getGroup(G);
+    Table.Keys.assign(Statuses.keys().begin(), Statuses.keys().end());
+    Table.Layout = strategy::BuildHashLayout(Table.Keys);
+    for (const NtStatus& Status : Statuses) {
+      Note N;
+      N.Off = pool.size();
+      pool += " (";
+      pool += Status.Name;
+      if (WithMessages && !Status.Message.empty()) {
+        pool += ": ";
+        AppendCollapsed(Status.Message, pool);
+      }
+      pool += ')';
+      N.Len = pool.size() - N.Off;
+      Table.Notes.push_back(N);
+    }
+  }
+}
+
+StringRef LogAnnotator::lookup(uint32_t ID) const {
+  // Same split as the parser: the severity nibble picks the group,
+  // the rest is the facility and code.
+  if ((ID >> (7 * 4)) & 0x3)
+    return StringRef();
+  const GroupTable& Table = groups[ID >> 30];
+  if (Table.Keys.empty())
+    return StringRef();
+
+  const uint32_t Key = ID & 0x0FFFFFFF;
+  const uint32_t Mask = Table.Layout.capacity() - 1;
+  uint32_t Slot = HashLayout::Hash(Key, Table.Layout.Shift);
+  for (;; Slot = (Slot + 1) & Mask) {
+    const uint32_t Ix = Table.Layout.Slots[Slot];
+    if (Ix == HashLayout::Empty)
+      return StringRef();
+    if (Table.Keys[Ix] == Key) {
+      const Note& N = Table.Notes[Ix];
+      return StringRef(pool).substr(N.Off, N.Len);
+    }
+  }
+}
+
+void LogAnnotator::annotate(StringRef Text, std::string& Out) const {
+  const char* const Data = Text.data();
+  const size_t Size = Text.size();
+  size_t Copied = 0;
+  size_t Ix = 0;
+  Out.reserve(Out.size() + Size + Size / 8);
+
+  // Tokens are found through their `x`, which is much rarer in logs
+  // than the leading `0`. `x | 0x20` only equals 'x' for 'x' and 'X'.
+#ifdef __SSE2__
+  const __m128i Lower = _mm_set1_epi8(0x20);
+  const __m128i LowerX = _mm_set1_epi8('x');
+  for (; Ix + 16 <= Size; Ix += 16) {
+    const __m128i Block = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(Data + Ix));
+    const __m128i IsX = _mm_cmpeq_epi8(_mm_or_si128(Block, Lower), LowerX);
+    for (unsigned Hits = _mm_movemask_epi8(IsX); Hits; Hits &= Hits - 1)
+      visitToken(Data, Size, Ix + countTrailingZeros(Hits), Copied, Out);
+  }
+#endif
+  for (; Ix < Size; ++Ix) {
+    if ((Data[Ix] | 0x20) == 'x')
+      visitToken(Data, Size, Ix, Copied, Out);
+  }
+  Out.append(Data + Copied, Size - Copied);
+}
+
+void LogAnnotator::visitToken(const char* Data, size_t Size,
+ size_t X, size_t& Copied, std::string& Out) const {
+  if (X == 0 || X + 9 > Size || Data[X - 1] != '0')
+    return;
+  if (X >= 2 && IsWordChar(Data[X - 2]))
+    return;
+  if (X + 9 < Size && IsWordChar(Data[X + 9]))
+    return;
+
+  uint32_t ID = 0;
+  for (size_t Digit = X + 1; Digit < X + 9; ++Digit) {
+    const unsigned Value = hexDigitValue(Data[Digit]);
+    if (Value == -1U)
+      return;
+    ID = (ID << 4) | Value;
+  }
+
+  const StringRef Annotation = lookup(ID);
+  if (Annotation.empty())
+    return;
+  Out.append(Data + Copied, X + 9 - Copied);
+  Out += Annotation;
+  Copied = X + 9;
+}
+
+Error LogAnnotator::annotateFile(sys::fs::file_t In,
+ raw_ostream& OS, unsigned Threads) const {
+  struct Chunk {
+    std::string Text;
+    std::string Out;
+    std::shared_future<void> Done;
+  };
+  // Declared before the pool, so pending chunks outlive its workers.
+  std::deque<std::unique_ptr<Chunk>> Pending;
+  ThreadPool Pool(hardware_concurrency(Threads));
+  const size_t MaxPending = 2 * Pool.getThreadCount();
+  auto WriteOldest = [&] {
+    Chunk& C = *Pending.front();
+    C.Done.wait();
+    OS << C.Out;
+    Pending.pop_front();
+  };
+
+  std::string Carry;
+  for (bool AtEnd = false; !AtEnd;) {
+    auto C = std::make_unique<Chunk>();
+    std::string& Text = C->Text;
+    Text = std::move(Carry);
+    size_t Filled = Text.size();
+    Text.resize(Filled + ChunkSize);
+    while (Filled < Text.size()) {
+      Expected<size_t> Read = sys::fs::readNativeFile(In,
+        makeMutableArrayRef(Text.data() + Filled, Text.size() - Filled));
+      if (!Read)
+        return Read.takeError();
+      if (*Read == 0) {
+        AtEnd = true;
+        break;
+      }
+      Filled += *Read;
+    }
+    Text.resize(Filled);
+
+    // The partial last line goes to the next chunk. Lines longer
+    // than a chunk keep growing it until they end.
+    Carry.clear();
+    if (!AtEnd) {
+      const size_t LineEnd = Text.rfind('\n');
+      if (LineEnd == std::string::npos) {
+        Carry = std::move(Text);
+        continue;
+      }
+      Carry.assign(Text, LineEnd + 1);
+      Text.resize(LineEnd + 1);
+    }
+    if (Text.empty())
+      continue;
+
+    if (Pending.size() == MaxPending)
+      WriteOldest();
+    Chunk* Ptr = C.get();
+    Ptr->Done = Pool.async([this, Ptr] {
+      annotate(Ptr->Text, Ptr->Out);
+    });
+    Pending.push_back(std::move(C));
+  }
+
+  while (!Pending.empty())
+    WriteOldest();
+  return Error::success();
+}
+
+//=== Statics ===//
+
+bool IsWordChar(char C) {
+  return isAlnum(C) || C == '_';
+}
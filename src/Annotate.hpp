@@ -0,0 +1,72 @@
+//===- Annotate.hpp -------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Annotates logs containing raw status codes with their names, using
+// the tables of a parsed `Catalog`.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "NtCode.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include <string>
+
+namespace ntcode {
+
+/// Follows every `0x` + 8 hex digit token naming a status of the
+/// catalog with ` (NAME)`, or ` (NAME: message)`. Tokens that are
+/// part of a longer word, like `0x0000000012`, are left alone.
+/// The annotator owns its strings, so it outlives the parsed buffer.
+class LogAnnotator {
+  struct Note {
+    uint32_t Off, Len;
+  };
+  /// Entries of one severity, keyed by `(SG << 12) | Code`.
+  struct GroupTable {
+    llvm::SmallVector<uint32_t, 0> Keys;
+    llvm::SmallVector<Note, 0> Notes;
+    HashLayout Layout;
+  };
+public:
+  explicit LogAnnotator(const Catalog& C, bool WithMessages = false);
+
+  /// The text added after `ID`, or empty if it isn't in the catalog.
+  [[nodiscard]] StringRef lookup(uint32_t ID) const;
+  /// Appends `Text` to `Out`, annotated. Tokens can't span calls,
+  /// so `Text` should end on a line boundary.
+  void annotate(StringRef Text, std::string& Out) const;
+  /// Annotates `In` into `OS`, a chunk of lines at a time. Chunks are
+  /// annotated on up to `Threads` threads (0 uses every core), while
+  /// the next ones are read, and are written in input order.
+  llvm::Error annotateFile(llvm::sys::fs::file_t In,
+    llvm::raw_ostream& OS, unsigned Threads = 0) const;
+
+private:
+  void visitToken(const char* Data, size_t Size, size_t X,
+    size_t& Copied, std::string& Out) const;
+
+private:
+  /// Indexed by the severity nibble's top two bits.
+  GroupTable groups[4];
+  std::string pool;
+};
+
+} // namespace ntcode
@@ -17,18 +17,22 @@
 //===----------------------------------------------------------------===//
 
 #include "Emitter.hpp"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/WithColor.h"
+#include <numeric>
 
 using namespace llvm;
 
 using StatusGroupRef = GroupEmitter::StatusGroupRef;
 using EmitterMsgType = GroupEmitter::EmitterMsgType;
 
-static StringRef GetGroupName(StatusGroup Group);
 static std::string MakePascalcase(StringRef Name);
-static llvm::FormattedNumber FormatMergedCode(const NtStatus& Status);
-static uint32_t MergeStatusAndCode(const NtStatus& Status);
+static std::string GetFacilityName(Subgroup SG);
+static SmallVector<StatusSpan, 0> SplitFacilities(
+  StatusGroupRef Statuses, NtCodeParser::StatusGroupVec& Storage);
 
 namespace {
   template <typename T>
@@ -49,39 +53,149 @@ namespace {
   template <typename T>
   WithColor& operator<<(WithColor& OS, BindColor<T> B) {
     return OS.changeColor(B.getColor())
-      << B.getValue() << raw_ostream::GREEN;
+      << B.getValue() << raw_ostream::Colors::GREEN;
   }
 } // namespace `anonymous`
 
 
-GroupEmitter::GroupEmitter(raw_ostream& OS) : OS(OS) {
+GroupEmitter::GroupEmitter(raw_ostream& OS, const ParserOptions& Opts) :
+ OS(OS), opts(Opts) {
   this->isDebug = OS.is_displayed();
   if (isDebug)
     outs() << "Debugging." << '\n';
 }
 
+StatusGroupRef GroupEmitter::orderByHits(
+ StatusGroup G, StatusGroupRef Statuses) {
+  const HitProfile& Profile = opts.getHitProfile();
+  if (Profile.empty())
+    return Statuses;
+
+  // Hot entries share the first cache lines of their table, the rest
+  // keep source order.
+  SmallVector<uint64_t, 0> Hits;
+  Hits.reserve(Statuses.size());
+  for (size_t Ix = 0; Ix < Statuses.size(); ++Ix) {
+    const uint32_t ID = (uint32_t(G) << (7 * 4)) | Statuses.keys()[Ix];
+    Hits.push_back(Profile.lookup(ID, Statuses[Ix].Name));
+  }
+  SmallVector<uint32_t, 0> Order(Statuses.size());
+  std::iota(Order.begin(), Order.end(), 0);
+  std::stable_sort(Order.begin(), Order.end(),
+    [&Hits](uint32_t L, uint32_t R) { return Hits[L] > Hits[R]; });
+
+  auto& Ordered = *splitStorage.emplace_back(
+    std::make_unique<NtCodeParser::StatusGroupVec>());
+  Ordered.reset(Statuses.getSource());
+  Ordered.reserve(Order.size());
+  for (uint32_t Ix : Order)
+    Ordered.push_back(Statuses, Ix);
+  return Ordered;
+}
+
 WithColor GroupEmitter::idbgs() const {
+  // Emitters render concurrently, so they can't share `nulls()`.
   if (!this->isDebug)
-    return WithColor(nulls());
+    return WithColor(silentOS);
   return WithColor(OS, raw_ostream::GREEN);
 }
 
 //=== Implementation ===//
 
 void GroupEmitter::emit(
- StatusGroup G, StatusGroupRef Statuses) {
+ StatusGroup G, StatusGroupRef Input) {
   groupName = GetGroupName(G);
-  if (!doEmit(G, Statuses)) {
-    didEmitSuccessfully = false;
-    failures.push_back(groupName);
+  const auto* Statuses = &orderByHits(G, Input);
+  if (!opts.isLargeGroup(*Statuses)) {
+    pieces.push_back({groupName, [G, Statuses] (GroupEmitter& E) {
+      return E.linearEmit(G, *Statuses);
+    }});
+    return;
+  }
+
+  // Facilities are independent, so each one gets its own piece.
+  // The split is stable, so hot entries stay first in each.
+  auto& Sorted = *splitStorage.emplace_back(
+    std::make_unique<NtCodeParser::StatusGroupVec>());
+  auto Facilities = SplitFacilities(*Statuses, Sorted);
+  pieces.push_back({groupName, [G, Statuses] (GroupEmitter& E) {
+    E.groupedHead(G, *Statuses);
+    return true;
+  }});
+  for (StatusSpan Facility : Facilities) {
+    pieces.push_back({groupName, [Facility] (GroupEmitter& E) {
+      E.emitFacility(Facility);
+      return true;
+    }});
   }
+  pieces.push_back({groupName, [Facilities] (GroupEmitter& E) {
+    E.groupedTail(Facilities);
+    return true;
+  }});
 }
 
-bool GroupEmitter::doEmit(
- StatusGroup G, StatusGroupRef Statuses) {
-  if (NtCodeParser::IsLargeGroup(Statuses))
-    return groupedEmit(G, Statuses);
-  return linearEmit(G, Statuses);
+void GroupEmitter::emitVerbatim(StatusGroup G,
+ StringRef Text, ArrayRef<StrategyChoice> Strategies) {
+  NtCodeParser::StrategyVec Saved(Strategies.begin(), Strategies.end());
+  pieces.push_back({GetGroupName(G),
+   [Text, Saved = std::move(Saved)] (GroupEmitter& E) {
+    E.OS << Text;
+    E.strategies.append(Saved.begin(), Saved.end());
+    return true;
+  }});
+}
+
+void GroupEmitter::flush() {
+  struct Worker {
+    Worker(const Piece& P, const ParserOptions& Opts, bool IsDebug) :
+     E(OS, Opts) {
+      E.isDebug = IsDebug;
+      E.groupName = P.Group;
+    }
+  public:
+    SmallString<0> Buffer;
+    raw_svector_ostream OS {Buffer};
+    GroupEmitter E;
+    bool WasSuccessful = false;
+  };
+
+  rendered.clear();
+  SmallVector<std::unique_ptr<Worker>, 0> Workers;
+  Workers.reserve(pieces.size());
+  for (const Piece& P : pieces)
+    Workers.push_back(std::make_unique<Worker>(P, opts, isDebug));
+
+  auto Run = [this, &Workers] (size_t Ix) {
+    Worker& W = *Workers[Ix];
+    W.WasSuccessful = pieces[Ix].Render(W.E);
+  };
+
+  const unsigned Threads = opts.EmitThreads;
+  if (Threads == 1 || pieces.size() <= 1) {
+    for (size_t Ix = 0; Ix < pieces.size(); ++Ix)
+      Run(Ix);
+  } else {
+    ThreadPool Pool(hardware_concurrency(Threads));
+    for (size_t Ix = 0; Ix < pieces.size(); ++Ix)
+      Pool.async(Run, Ix);
+    Pool.wait();
+  }
+
+  // Splice in submission order, so the output never depends on timing.
+  for (size_t Ix = 0; Ix < pieces.size(); ++Ix) {
+    Worker& W = *Workers[Ix];
+    OS << W.Buffer;
+    rendered[pieces[Ix].Group] += W.Buffer;
+    strategies.append(W.E.strategies.begin(), W.E.strategies.end());
+    const StringRef Group = pieces[Ix].Group;
+    if (!W.WasSuccessful && !is_contained(failures, Group)) {
+      didEmitSuccessfully = false;
+      failures.push_back(Group);
+    }
+  }
+
+  pieces.clear();
+  splitStorage.clear();
 }
 
 const EmitterMsgType& GroupEmitter::formatMessage(const NtStatus& Status) {
@@ -90,9 +204,11 @@ const EmitterMsgType& GroupEmitter::formatMessage(const NtStatus& Status) {
   StringRef Msg = Status.Message;
   SmallString<64> MsgFragment;
   
-  while ((Pos = Msg.find("\r\n")) != StringRef::npos) {
-    storedMsg.append(Msg.take_front(Pos));
-    Msg = Msg.drop_front(Pos + 2);
+  // Messages are emitted as string literals, so their lines are
+  // joined. The catalog may be checked out with LF or CRLF endings.
+  while ((Pos = Msg.find('\n')) != StringRef::npos) {
+    storedMsg.append(Msg.take_front(Pos).rtrim('\r'));
+    Msg = Msg.drop_front(Pos + 1);
   }
 
   storedMsg.append(Msg);
@@ -101,13 +217,42 @@ const EmitterMsgType& GroupEmitter::formatMessage(const NtStatus& Status) {
 
 // emitters
 
-void GroupEmitter::emitTableSwitchPair(
- StatusSpan Statuses, StringRef FuncName, StringRef TableName) {
-  emitTable(Statuses, "table");
-  OS.indent(2) << "static OpaqueError "
-    << FuncName << "(OpqErrorID ID) {\n";
-  emitSwitch(Statuses, "table");
-  OS.indent(2) << "}\n";
+void GroupEmitter::emitTableLookupPair(
+ StatusSpan Statuses, KeySpan Keys, StringRef FuncName,
+ StringRef TableName, std::optional<Subgroup> SG) {
+  if (Statuses.empty()) {
+    OS.indent(2) << "static constexpr OpaqueError "
+      << FuncName << "(OpqErrorID) {\n";
+    OS.indent(4) << "return nullptr;\n";
+    OS.indent(2) << "}\n";
+    return;
+  }
+
+  const StrategyCost Cost = strategy::Choose(
+    Keys, opts.StrategyOverride);
+  strategies.push_back({groupName, SG, strategy::Measure(Keys), Cost});
+  idbgs() << "Using " 
+    << BindColor(strategy::GetName(Cost.Kind), YELLOW)
+    << " lookup (~" << Cost.Bytes << " bytes).\n";
+
+  emitTable(Statuses, TableName);
+  switch (Cost.Kind) {
+   case EmitStrategy::Dense:
+    emitDense(Keys, FuncName, TableName);
+    break;
+   case EmitStrategy::Sorted:
+    emitSorted(Keys, FuncName, TableName);
+    break;
+   case EmitStrategy::Hashed:
+    emitHashed(Keys, FuncName, TableName);
+    break;
+   default:
+    OS.indent(2) << "static constexpr OpaqueError "
+      << FuncName << "(OpqErrorID ID) {\n";
+    emitSwitch(Keys, TableName);
+    OS.indent(2) << "}\n";
+    break;
+  }
 }
 
 void GroupEmitter::emitTable(
@@ -126,20 +271,107 @@ void GroupEmitter::emitTableValue(const NtStatus& Status, bool NoComma) {
     << (NoComma ? "" : ",") << '\n';
 }
 
-void GroupEmitter::emitSwitch(StatusSpan Statuses, StringRef TableName) {
+void GroupEmitter::emitArray(StringRef Type,
+ StringRef Name, KeySpan Values, bool AsHex, unsigned HexWidth) {
+  const size_t PerLine = AsHex ? 8 : 16;
+  OS.indent(2) << "static constexpr " << Type
+    << ' ' << Name << "[] {";
+  for (size_t Ix = 0; Ix < Values.size(); ++Ix) {
+    if (Ix % PerLine == 0)
+      OS << '\n', OS.indent(4);
+    else
+      OS << ' ';
+    if (AsHex)
+      OS << format_hex(Values[Ix], HexWidth, true);
+    else
+      OS << Values[Ix];
+    if (Ix + 1 != Values.size())
+      OS << ',';
+  }
+  OS << '\n';
+  OS.indent(2) << "};\n\n";
+}
+
+void GroupEmitter::emitSwitch(KeySpan Keys, StringRef TableName) {
   OS.indent(4) << "switch (ID) {\n";
-  for (uint64_t Ix = 0; Ix < Statuses.size(); ++Ix)
-    emitSwitchValue(Statuses[Ix], TableName, Ix);
+  for (uint64_t Ix = 0; Ix < Keys.size(); ++Ix)
+    emitSwitchValue(Keys[Ix], TableName, Ix);
   OS.indent(5) << "default: return nullptr;\n";
   OS.indent(4) << "}\n";
 }
 
 void GroupEmitter::emitSwitchValue(
- const NtStatus& Status, StringRef TableName, uint64_t Ix) {
-  OS.indent(5) << "case " << FormatMergedCode(Status)
+ uint32_t Key, StringRef TableName, uint64_t Ix) {
+  OS.indent(5) << "case " << format_hex(Key, 8, true)
     << ": return &" << TableName << "[" << Ix << "];\n";
 }
 
+void GroupEmitter::emitDense(
+ KeySpan Keys, StringRef FuncName, StringRef TableName) {
+  const CodeDistribution Dist = strategy::Measure(Keys);
+  SmallVector<uint32_t, 0> Index(Dist.span(), 0);
+  for (uint32_t Ix = 0; Ix < Keys.size(); ++Ix)
+    Index[Keys[Ix] - Dist.Min] = Ix + 1;
+  emitArray(strategy::GetIndexType(Keys.size()), "index", Index);
+
+  OS.indent(2) << "static constexpr OpaqueError "
+    << FuncName << "(OpqErrorID ID) {\n";
+  OS.indent(4) << "const uint32_t off = uint32_t(ID) - "
+    << format_hex(Dist.Min, 8, true) << ";\n";
+  OS.indent(4) << "if (off >= " << Dist.span() << ")\n";
+  OS.indent(6) << "return nullptr;\n";
+  OS.indent(4) << "const unsigned ix = index[off];\n";
+  OS.indent(4) << "return ix ? &" << TableName
+    << "[ix - 1] : nullptr;\n";
+  OS.indent(2) << "}\n";
+}
+
+void GroupEmitter::emitSorted(
+ KeySpan Keys, StringRef FuncName, StringRef TableName) {
+  SmallVector<uint32_t, 0> Index(Keys.size());
+  std::iota(Index.begin(), Index.end(), 0);
+  llvm::sort(Index, [Keys](uint32_t L, uint32_t R) {
+    return Keys[L] < Keys[R];
+  });
+  SmallVector<uint32_t, 0> Sorted;
+  Sorted.reserve(Keys.size());
+  for (uint32_t Ix : Index)
+    Sorted.push_back(Keys[Ix]);
+  emitArray("uint32_t", "keys", Sorted, true);
+  emitArray(strategy::GetIndexType(Keys.size()), "index", Index);
+
+  OS.indent(2) << "static constexpr OpaqueError "
+    << FuncName << "(OpqErrorID ID) {\n";
+  OS.indent(4) << "const int pos = $FindSorted(keys, ID);\n";
+  OS.indent(4) << "return (pos < 0) ? nullptr : &"
+    << TableName << "[index[pos]];\n";
+  OS.indent(2) << "}\n";
+}
+
+void GroupEmitter::emitHashed(
+ KeySpan Keys, StringRef FuncName, StringRef TableName) {
+  const HashLayout Layout = strategy::BuildHashLayout(Keys);
+  SmallVector<uint32_t, 0> SlotKeys(Layout.capacity(), HashLayout::Empty);
+  SmallVector<uint32_t, 0> Index(Layout.capacity(), 0);
+  for (size_t Slot = 0; Slot < Layout.capacity(); ++Slot) {
+    const uint32_t Ix = Layout.Slots[Slot];
+    if (Ix == HashLayout::Empty)
+      continue;
+    SlotKeys[Slot] = Keys[Ix];
+    Index[Slot] = Ix;
+  }
+  emitArray("uint32_t", "keys", SlotKeys, true);
+  emitArray(strategy::GetIndexType(Keys.size()), "index", Index);
+
+  OS.indent(2) << "static constexpr OpaqueError "
+    << FuncName << "(OpqErrorID ID) {\n";
+  OS.indent(4) << "const int pos = $FindHashed(keys, ID, "
+    << Layout.Shift << ");\n";
+  OS.indent(4) << "return (pos < 0) ? nullptr : &"
+    << TableName << "[index[pos]];\n";
+  OS.indent(2) << "}\n";
+}
+
 // linear
 
 bool GroupEmitter::linearEmit(
@@ -148,9 +380,13 @@ bool GroupEmitter::linearEmit(
     << BindColor(groupName, YELLOW)
     << " is linear (Size: " << Statuses.size() << ").\n";
 
+  // Linear tables are keyed by `(SG << 12) | Code`, as stored.
+  const KeySpan Keys = Statuses.keys();
   OS << "#define CURR_SEVERITY " << groupName << "\n";
   OS << "struct _" << groupName << "Group {\n";
-  emitTableSwitchPair(Statuses, "Get", "table");
+  emitTableLookupPair(Statuses, Keys, "Get", "table");
+  OS << '\n';
+  emitLinearBatch();
   OS << "};\n" << "#undef CURR_SEVERITY\n\n";
 
   return true;
@@ -158,21 +394,314 @@ bool GroupEmitter::linearEmit(
 
 // grouped
 
-bool GroupEmitter::groupedEmit(
+void GroupEmitter::groupedHead(
  StatusGroup G, StatusGroupRef Statuses) {
   idbgs() << "Group " 
     << BindColor(GetGroupName(G), YELLOW)
     << " is batched (Size: " << Statuses.size() << ").\n";
-  
-  bool WasSuccessful = true;
+  OS << "#define CURR_SEVERITY " << groupName << "\n";
+}
 
-  WasSuccessful = false;
-  return WasSuccessful;
+void GroupEmitter::emitFacility(StatusSpan Facility) {
+  const Subgroup SG = Facility.subgroup(0);
+  SmallVector<uint32_t, 0> Keys;
+  Keys.reserve(Facility.size());
+  for (uint32_t Key : Facility.keys())
+    Keys.push_back(Key & 0xFFF);
+
+  idbgs() << "Facility " << BindColor(GetFacilityName(SG), YELLOW)
+    << " (Size: " << Facility.size() << ").\n";
+  OS << "struct _" << groupName << "Group_"
+    << GetFacilityName(SG) << " {\n";
+  emitTableLookupPair(Facility, Keys, "Get", "table", SG);
+  OS << "};\n\n";
+}
+
+void GroupEmitter::groupedTail(ArrayRef<StatusSpan> Facilities) {
+  OS << "struct _" << groupName << "Group {\n";
+  emitFacilityDispatch(Facilities);
+  emitFacilityBatch(Facilities);
+  OS << "};\n" << "#undef CURR_SEVERITY\n\n";
+}
+
+void GroupEmitter::emitFacilityDispatch(ArrayRef<StatusSpan> Facilities) {
+  OS.indent(2) << "static constexpr OpaqueError Get(OpqErrorID ID) {\n";
+  OS.indent(4) << "switch (ID >> 12) {\n";
+  for (StatusSpan Facility : Facilities) {
+    const Subgroup SG = Facility.subgroup(0);
+    OS.indent(5) << "case " << format_hex(uint32_t(SG), 5, true)
+      << ": return _" << groupName << "Group_" << GetFacilityName(SG)
+      << "::Get(ID & 0xFFF);\n";
+  }
+  OS.indent(5) << "default: return nullptr;\n";
+  OS.indent(4) << "}\n";
+  OS.indent(2) << "}\n\n";
+
+  // Maps an ID to its position in `Facilities`, or `Count` if it has
+  // none. This is a table rather than a switch so batches don't branch
+  // on random facilities.
+  const size_t Count = Facilities.size();
+  const uint32_t MaxSG = Count ? uint32_t(Facilities.back().subgroup(0)) : 0;
+  SmallVector<uint32_t, 0> FacilityIndex(MaxSG + 1, Count);
+  for (size_t Ix = 0; Ix < Count; ++Ix)
+    FacilityIndex[uint32_t(Facilities[Ix].subgroup(0))] = Ix;
+  emitArray(strategy::GetIndexType(Count), "facility", FacilityIndex);
+  OS.indent(2) << "static unsigned Facility(OpqErrorID ID) {\n";
+  OS.indent(4) << "const uint32_t sg = (ID >> 12) & 0xFFFF;\n";
+  OS.indent(4) << "return (sg <= " << format_hex(MaxSG, 5, true)
+    << ") ? facility[sg] : " << Count << ";\n";
+  OS.indent(2) << "}\n\n";
+}
+
+// batched
+
+void GroupEmitter::emitBatchSignature() {
+  OS.indent(2) << "static void GetBatch(const OpqErrorID* ids, "
+    << "const uint16_t* pos, size_t n, OpaqueError* out) {\n";
+}
+
+void GroupEmitter::emitLinearBatch() {
+  // Linear groups have a single table, so the facility partitioning in
+  // `emitFacilityBatch` would only put every ID in the same bucket.
+  emitBatchSignature();
+  OS.indent(4) << "for (size_t i = 0; i < n; ++i)\n";
+  OS.indent(6) << "out[pos[i]] = Get(ids[pos[i]] & 0x0FFFFFFF);\n";
+  OS.indent(2) << "}\n";
+}
+
+void GroupEmitter::emitFacilityBatch(ArrayRef<StatusSpan> Facilities) {
+  const size_t Count = Facilities.size();
+  const StringRef FacType = strategy::GetIndexType(Count);
+  emitBatchSignature();
+  // Counting sort by facility, then one tight loop per table.
+  OS.indent(4) << FacType << " fac[$BatchBlock];\n";
+  OS.indent(4) << "uint16_t sorted[$BatchBlock];\n";
+  OS.indent(4) << "uint16_t start[" << Count + 2 << "] {};\n";
+  OS.indent(4) << "for (size_t i = 0; i < n; ++i) {\n";
+  OS.indent(6) << "fac[i] = " << FacType << "(Facility(ids[pos[i]]));\n";
+  OS.indent(6) << "++start[fac[i] + 1];\n";
+  OS.indent(4) << "}\n";
+  OS.indent(4) << "for (size_t f = 1; f < " << Count + 2 << "; ++f)\n";
+  OS.indent(6) << "start[f] += start[f - 1];\n";
+  OS.indent(4) << "uint16_t next[" << Count + 1 << "];\n";
+  OS.indent(4) << "std::copy_n(start, " << Count + 1 << ", next);\n";
+  OS.indent(4) << "for (size_t i = 0; i < n; ++i)\n";
+  OS.indent(6) << "sorted[next[fac[i]]++] = pos[i];\n\n";
+
+  for (size_t Ix = 0; Ix < Count; ++Ix) {
+    const Subgroup SG = Facilities[Ix].subgroup(0);
+    OS.indent(4) << "for (size_t i = start[" << Ix << "]; i < start["
+      << Ix + 1 << "]; ++i)\n";
+    OS.indent(6) << "out[sorted[i]] = _" << groupName << "Group_"
+      << GetFacilityName(SG) << "::Get(ids[sorted[i]] & 0xFFF);\n";
+  }
+  OS.indent(4) << "for (size_t i = start[" << Count << "]; i < n; ++i)\n";
+  OS.indent(6) << "out[sorted[i]] = nullptr;\n";
+  OS.indent(2) << "}\n";
+}
+
+// data
+
+bool GroupEmitter::dataEmit(
+ ArrayRef<std::pair<StatusGroup, StatusSpan>> Groups, bool SplitCold) {
+  struct Row {
+    uint32_t ID;
+    uint32_t Name, Msg;
+  };
+  /// Deduplicated strings, laid out back to back with terminators.
+  struct StringPool {
+    StringMap<uint32_t> Offsets;
+    SmallVector<StringRef, 0> Strings;
+    uint32_t Size = 0;
+  public:
+    uint32_t intern(StringRef Str) {
+      auto [It, Inserted] = Offsets.try_emplace(Str, Size);
+      if (Inserted) {
+        Strings.push_back(It->first());
+        Size += Str.size() + 1;
+      }
+      return It->second;
+    }
+  };
+  SmallVector<Row, 0> Rows;
+  StringPool Names, Messages;
+  StringPool& MessagePool = SplitCold ? Messages : Names;
+
+  for (auto [G, Statuses] : Groups) {
+    groupName = GetGroupName(G);
+    for (size_t Ix = 0; Ix < Statuses.size(); ++Ix) {
+      const NtStatus Status = Statuses[Ix];
+      const uint32_t Name = Names.intern(MakePascalcase(Status.Name));
+      const uint32_t Msg = MessagePool.intern(formatMessage(Status));
+      Rows.push_back({(uint32_t(G) << (7 * 4)) | Statuses.keys()[Ix],
+        Name, Msg});
+    }
+  }
+  llvm::sort(Rows, [](const Row& L, const Row& R) { return L.ID < R.ID; });
+  idbgs() << "Catalog has " << Rows.size() << " entries and "
+    << (Names.Size + Messages.Size) << " bytes of strings.\n";
+  // Empty arrays are ill-formed, the caller emits a stub lookup.
+  if (Rows.empty())
+    return false;
+
+  auto EmitPool = [this] (const StringPool& Pool) {
+    OS.indent(2) << "static constexpr char strings[] =";
+    for (StringRef Str : Pool.Strings) {
+      OS << '\n';
+      OS.indent(4) << '"';
+      OS.write_escaped(Str);
+      OS << "\\0\"";
+    }
+    OS << ";\n";
+  };
+
+  SmallVector<uint32_t, 0> Codes, Index;
+  Codes.reserve(Rows.size());
+  Index.reserve(Rows.size() * 2);
+  for (const Row& R : Rows)
+    Codes.push_back(R.ID);
+
+  if (!SplitCold) {
+    for (const Row& R : Rows) {
+      Index.push_back(R.Name);
+      Index.push_back(R.Msg);
+    }
+    OS << "struct $Catalog {\n";
+    emitArray("uint32_t", "codes", Codes, true, 10);
+    OS.indent(2) << "/// Offsets of each entry's name and message.\n";
+    emitArray("uint32_t", "index", Index);
+    EmitPool(Names);
+    OS << "};\n\n";
+    return true;
+  }
+
+  // Lookups only touch `$Catalog`, the severity being the top bits
+  // of each code. The message offsets are kept there too, so building
+  // an entry only points into `$Cold` and never reads it.
+  SmallVector<uint32_t, 0> MsgIndex;
+  MsgIndex.reserve(Rows.size());
+  for (const Row& R : Rows) {
+    Index.push_back(R.Name);
+    MsgIndex.push_back(R.Msg);
+  }
+  OS << "struct $Catalog {\n";
+  emitArray("uint32_t", "codes", Codes, true, 10);
+  OS.indent(2) << "/// Offset of each entry's name.\n";
+  emitArray((Names.Size <= UINT16_MAX) ? "uint16_t" : "uint32_t",
+    "names", Index);
+  OS.indent(2) << "/// Offset of each entry's message in `$Cold`.\n";
+  emitArray((Messages.Size <= UINT16_MAX) ? "uint16_t" : "uint32_t",
+    "messages", MsgIndex);
+  EmitPool(Names);
+  OS << "};\n\n";
+
+  OS << "struct $Cold {\n";
+  OS.indent(2) << "$ColdData\n";
+  EmitPool(Messages);
+  OS << "};\n\n";
+  return true;
+}
+
+// report
+
+void GroupEmitter::report(
+ StatusGroup G, StatusGroupRef Statuses) {
+  groupName = GetGroupName(G);
+  FootprintRow GroupRow {.Group = groupName, .SG = std::nullopt};
+  // Strings are pooled per translation unit, so dedup across the group.
+  StringSet<> GroupStrings;
+
+  auto AddStrings = [this] (FootprintRow& Row, StringSet<>& Pool,
+   const NtStatus& Status) {
+    for (std::string Str : {
+        MakePascalcase(Status.Name),
+        std::string(formatMessage(Status).str())}) {
+      Row.StringBytes += Str.size() + 1;
+      if (Pool.insert(Str).second)
+        Row.UniqueStringBytes += Str.size() + 1;
+    }
+  };
+
+  auto ReportTable = [&] (StatusSpan Table, Subgroup SG,
+   const StrategyCost& Cost, bool OwnsLookup) {
+    FootprintRow Row {.Group = groupName, .SG = SG};
+    StringSet<> Strings;
+    Row.Entries = Table.size();
+    Row.TableBytes = Table.size() * FootprintRow::EntryBytes;
+    if (OwnsLookup)
+      Row.TableBytes += Cost.Bytes;
+    if (Cost.Kind == EmitStrategy::Switch)
+      Row.SwitchCases = Table.size();
+    for (const NtStatus& Status : Table) {
+      AddStrings(Row, Strings, Status);
+      AddStrings(GroupRow, GroupStrings, Status);
+    }
+    GroupRow.Entries += Row.Entries;
+    GroupRow.TableBytes += Row.TableBytes;
+    GroupRow.SwitchCases += Row.SwitchCases;
+    footprint.push_back(Row);
+  };
+
+  if (opts.Mode == EmitMode::Data) {
+    // Everything shares one lookup, so only the arrays are counted.
+    GroupRow.Entries = Statuses.size();
+    GroupRow.TableBytes = Statuses.size() * FootprintRow::DataEntryBytes;
+    for (const NtStatus& Status : Statuses)
+      AddStrings(GroupRow, GroupStrings, Status);
+    footprint.push_back(GroupRow);
+    return;
+  }
+  if (opts.Mode == EmitMode::Split) {
+    // Lookups only touch the offsets and names, messages are cold.
+    StringSet<> Messages;
+    GroupRow.Entries = Statuses.size();
+    GroupRow.TableBytes = Statuses.size() * FootprintRow::SplitEntryBytes;
+    for (const NtStatus& Status : Statuses) {
+      const std::string Name = MakePascalcase(Status.Name);
+      GroupRow.StringBytes += Name.size() + 1;
+      if (GroupStrings.insert(Name).second)
+        GroupRow.UniqueStringBytes += Name.size() + 1;
+      const StringRef Msg = formatMessage(Status);
+      if (Messages.insert(Msg).second)
+        GroupRow.ColdBytes += Msg.size() + 1;
+    }
+    footprint.push_back(GroupRow);
+    return;
+  }
+
+  NtCodeParser::StatusGroupVec Sorted;
+  auto Facilities = SplitFacilities(Statuses, Sorted);
+  if (opts.isLargeGroup(Statuses)) {
+    for (StatusSpan Facility : Facilities) {
+      SmallVector<uint32_t, 0> Keys;
+      for (uint32_t Key : Facility.keys())
+        Keys.push_back(Key & 0xFFF);
+      const StrategyCost Cost = strategy::Choose(
+        Keys, opts.StrategyOverride);
+      ReportTable(Facility, Facility.subgroup(0), Cost, true);
+    }
+    // The facility index and the `Get` dispatch switch.
+    if (!Facilities.empty()) {
+      const auto MaxSG = uint32_t(Facilities.back().subgroup(0));
+      GroupRow.TableBytes +=
+        (MaxSG + 1) * strategy::GetIndexSize(Facilities.size());
+      GroupRow.SwitchCases += Facilities.size();
+    }
+  } else if (!Statuses.empty()) {
+    // One lookup for the whole group, owned by the group row.
+    const StrategyCost Cost = strategy::Choose(
+      Statuses.keys(), opts.StrategyOverride);
+    for (StatusSpan Facility : Facilities)
+      ReportTable(Facility, Facility.subgroup(0), Cost, false);
+    GroupRow.TableBytes += Cost.Bytes;
+  }
+
+  footprint.push_back(GroupRow);
 }
 
 //=== Statics ===//
 
-StringRef GetGroupName(StatusGroup Group) {
+StringRef GroupEmitter::GetGroupName(StatusGroup Group) {
   switch (Group) {
    case StatusGroup::SUCCESS:
     return "Success";
@@ -208,12 +737,37 @@ std::string MakePascalcase(StringRef Name) {
   return Output;
 }
 
-llvm::FormattedNumber FormatMergedCode(const NtStatus& Status) {
-  const uint32_t SC = MergeStatusAndCode(Status);
-  return llvm::format_hex(SC, 8, true);
+std::string GetFacilityName(Subgroup SG) {
+  // RPC, NDIS and IPSEC span several facilities, so keep the ID.
+  std::string Name = NtCodeParser::GetSubgroupPrefix(SG).str();
+  raw_string_ostream(Name) << format_hex_no_prefix(uint32_t(SG), 3, true);
+  return Name;
 }
 
-uint32_t MergeStatusAndCode(const NtStatus& Status) {
-  auto RawSG = uint32_t(Status.SG) << (3 * 4);
-  return (RawSG | Status.Code);
+SmallVector<StatusSpan, 0> SplitFacilities(
+ StatusGroupRef Statuses, NtCodeParser::StatusGroupVec& Storage) {
+  // Split by facility, keeping source order within each.
+  // Only the keys are needed to find the order.
+  const ArrayRef<uint32_t> Keys = Statuses.keys();
+  SmallVector<uint32_t, 0> Order(Keys.size());
+  std::iota(Order.begin(), Order.end(), 0);
+  std::stable_sort(Order.begin(), Order.end(),
+   [Keys](uint32_t L, uint32_t R) {
+    return (Keys[L] >> 12) < (Keys[R] >> 12);
+  });
+  Storage.reset(Statuses.getSource());
+  Storage.reserve(Order.size());
+  for (uint32_t Ix : Order)
+    Storage.push_back(Statuses, Ix);
+
+  SmallVector<StatusSpan, 0> Facilities;
+  const ArrayRef<uint32_t> Sorted = Storage.keys();
+  for (size_t Begin = 0, End; Begin < Sorted.size(); Begin = End) {
+    End = Begin + 1;
+    while (End < Sorted.size()
+        && (Sorted[End] >> 12) == (Sorted[Begin] >> 12))
+      ++End;
+    Facilities.push_back(StatusSpan(Storage).slice(Begin, End - Begin));
+  }
+  return Facilities;
 }
@@ -20,8 +20,11 @@
 
 #include "Parser.hpp"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include <functional>
+#include <memory>
 
-using StatusSpan = llvm::ArrayRef<NtStatus>;
+using KeySpan = llvm::ArrayRef<uint32_t>;
 namespace llvm { struct WithColor; }
 
 struct GroupEmitter {
@@ -29,22 +32,56 @@ struct GroupEmitter {
   using enum llvm::raw_ostream::Colors;
   using StatusGroupRef = const NtCodeParser::StatusGroupVec&;
   using EmitterMsgType = llvm::SmallString<128>;
+  /// Output for part of a group, rendered into its own buffer.
+  struct Piece {
+    StringRef Group;
+    std::function<bool(GroupEmitter&)> Render;
+  };
 public:
-  GroupEmitter(llvm::raw_ostream& OS);
+  GroupEmitter(llvm::raw_ostream& OS, const ParserOptions& Opts);
 public:
+  /// Queues `G`, split into pieces that can render concurrently.
   void emit(StatusGroup G, StatusGroupRef Statuses);
-  bool doEmit(StatusGroup G, StatusGroupRef Statuses);
+  /// Queues output rendered by an earlier `flush`.
+  void emitVerbatim(StatusGroup G, StringRef Text,
+    llvm::ArrayRef<StrategyChoice> Strategies);
+  /// Renders the queued pieces and writes them out in order.
+  void flush();
+  static StringRef GetGroupName(StatusGroup G);
   const EmitterMsgType& formatMessage(const NtStatus& Status);
 
-  void emitTableSwitchPair(StatusSpan Statuses, StringRef FuncName, StringRef TableName);
+  void emitTableLookupPair(StatusSpan Statuses, KeySpan Keys,
+    StringRef FuncName, StringRef TableName, std::optional<Subgroup> SG = {});
   void emitTable(StatusSpan Statuses, StringRef Name);
   void emitTableValue(const NtStatus& Status, bool NoComma = false);
-  void emitSwitch(StatusSpan Statuses, StringRef TableName);
-  void emitSwitchValue(const NtStatus& Status, StringRef TableName, uint64_t Ix);
+  void emitArray(StringRef Type, StringRef Name,
+    KeySpan Values, bool AsHex = false, unsigned HexWidth = 8);
+  void emitSwitch(KeySpan Keys, StringRef TableName);
+  void emitSwitchValue(uint32_t Key, StringRef TableName, uint64_t Ix);
+  void emitDense(KeySpan Keys, StringRef FuncName, StringRef TableName);
+  void emitSorted(KeySpan Keys, StringRef FuncName, StringRef TableName);
+  void emitHashed(KeySpan Keys, StringRef FuncName, StringRef TableName);
 
+  void emitFacilityDispatch(llvm::ArrayRef<StatusSpan> Facilities);
+  void emitBatchSignature();
+  void emitLinearBatch();
+  void emitFacilityBatch(llvm::ArrayRef<StatusSpan> Facilities);
 
   bool linearEmit(StatusGroup G, StatusGroupRef Statuses);
-  bool groupedEmit(StatusGroup G, StatusGroupRef Statuses);
+  void groupedHead(StatusGroup G, StatusGroupRef Statuses);
+  void emitFacility(StatusSpan Facility);
+  void groupedTail(llvm::ArrayRef<StatusSpan> Facilities);
+
+  /// Emits every group as one sorted code array, an index into a
+  /// string pool, and the pool. Used for `EmitMode::Data`. With
+  /// `SplitCold`, messages get their own index and pool in `$Cold`,
+  /// for `EmitMode::Split`. Emits nothing and returns false if
+  /// there are no entries.
+  bool dataEmit(llvm::ArrayRef<std::pair<StatusGroup, StatusSpan>> Groups,
+    bool SplitCold = false);
+
+  /// Records the footprint of `G` without emitting anything.
+  void report(StatusGroup G, StatusGroupRef Statuses);
 
   [[nodiscard]] bool emitSuccessful() const { 
     return this->didEmitSuccessfully;
@@ -52,15 +89,35 @@ public:
   [[nodiscard]] llvm::ArrayRef<StringRef> getFailures() const { 
     return this->failures;
   }
+  [[nodiscard]] llvm::ArrayRef<StrategyChoice> getStrategies() const {
+    return this->strategies;
+  }
+  [[nodiscard]] llvm::ArrayRef<FootprintRow> getFootprint() const {
+    return this->footprint;
+  }
+  /// Everything `flush` wrote for `Group`.
+  [[nodiscard]] StringRef getRendered(StringRef Group) const {
+    auto It = this->rendered.find(Group);
+    return (It != this->rendered.end()) ? StringRef(It->second) : "";
+  }
 
 private:
   llvm::WithColor idbgs() const;
+  /// `Statuses` with profiled entries first, hottest first.
+  StatusGroupRef orderByHits(StatusGroup G, StatusGroupRef Statuses);
 
 private:
   llvm::raw_ostream& OS;
+  const ParserOptions& opts;
+  mutable llvm::raw_null_ostream silentOS;
   bool isDebug = false;
   bool didEmitSuccessfully = true;
   llvm::SmallVector<StringRef, 4> failures;
+  llvm::SmallVector<StrategyChoice, 0> strategies;
+  llvm::SmallVector<FootprintRow, 0> footprint;
+  llvm::SmallVector<Piece, 0> pieces;
+  llvm::StringMap<std::string> rendered;
+  llvm::SmallVector<std::unique_ptr<NtCodeParser::StatusGroupVec>, 0> splitStorage;
 
   StringRef groupName;
   EmitterMsgType storedMsg;
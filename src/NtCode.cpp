@@ -0,0 +1,73 @@
+//===- NtCode.cpp ---------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "NtCode.hpp"
+#include "llvm/ADT/StringExtras.h"
+
+using namespace llvm;
+using namespace ntcode;
+
+static Error MakeError(const NtCodeParser& Parser,
+  size_t FirstDiag, StringRef Fallback);
+
+Expected<Catalog> Catalog::parse(MemoryBufferRef MBRef,
+ ParserOptions Opts) {
+  auto Parser = std::make_unique<NtCodeParser>(MBRef, std::move(Opts));
+  if (!Parser->parseFile())
+    return MakeError(*Parser, 0, "Parsing failed.");
+  return Catalog(std::move(Parser));
+}
+
+Error Catalog::reparse(MemoryBufferRef MBRef) {
+  if (!Parser->reparse(MBRef))
+    return MakeError(*Parser, 0, "Parsing failed.");
+  return Error::success();
+}
+
+Error Catalog::emit(raw_ostream& OS) {
+  const size_t FirstDiag = Parser->getDiagnostics().size();
+  if (!Parser->emitGroupData(OS))
+    return MakeError(*Parser, FirstDiag, "Emission failed.");
+  return Error::success();
+}
+
+Error Catalog::writeToFile(StringRef Filename) {
+  const size_t FirstDiag = Parser->getDiagnostics().size();
+  if (!Parser->writeToFile(Filename))
+    return MakeError(*Parser, FirstDiag, "Writing failed.");
+  return Error::success();
+}
+
+void ntcode::AppendCollapsed(StringRef Message, std::string& Out) {
+  SmallVector<StringRef, 16> Words;
+  SplitString(Message, Words);
+  Out += join(Words, " ");
+}
+
+//=== Statics ===//
+
+Error MakeError(const NtCodeParser& Parser,
+ size_t FirstDiag, StringRef Fallback) {
+  // Only report what the failing call added.
+  ArrayRef<std::string> Diags =
+    Parser.getDiagnostics().drop_front(FirstDiag);
+  if (Diags.empty())
+    return createStringError(inconvertibleErrorCode(), Fallback);
+  return createStringError(inconvertibleErrorCode(),
+    Parser.getBufferID() + ": " + join(Diags, "\n"));
+}
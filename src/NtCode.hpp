@@ -0,0 +1,68 @@
+//===- NtCode.hpp ---------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// In-process entry points for the `ntcode` library. A `Catalog` is
+// parsed once and can then be emitted any number of times.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "Parser.hpp"
+#include "llvm/Support/Error.h"
+#include <memory>
+#include <string>
+
+namespace ntcode {
+
+/// A parsed NTSTATUS catalog, grouped by severity. Entries refer into
+/// the parsed buffer, which must outlive the catalog.
+class Catalog {
+  explicit Catalog(std::unique_ptr<NtCodeParser> Parser) :
+   Parser(std::move(Parser)) { }
+public:
+  static llvm::Expected<Catalog> parse(llvm::MemoryBufferRef MBRef,
+    ParserOptions Opts = {});
+
+  /// Replaces the catalog with a new version of the input, only
+  /// parsing the rows around what changed. The previous buffer can be
+  /// freed once this returns.
+  llvm::Error reparse(llvm::MemoryBufferRef MBRef);
+
+  [[nodiscard]] StatusSpan getGroup(StatusGroup G) const {
+    return Parser->getGroup(G);
+  }
+  /// Writes the generated source to `OS`.
+  llvm::Error emit(llvm::raw_ostream& OS);
+  /// Writes the generated source to `Filename` with a `.cpp` extension,
+  /// leaving it untouched if nothing changed.
+  llvm::Error writeToFile(StringRef Filename);
+
+  [[nodiscard]] NtCodeParser& getParser() { return *Parser; }
+  [[nodiscard]] const NtCodeParser& getParser() const { return *Parser; }
+
+private:
+  std::unique_ptr<NtCodeParser> Parser;
+};
+
+/// Appends `Message` to `Out` with its whitespace collapsed to single
+/// spaces. Messages can span lines, while search hits and annotations
+/// are printed on one.
+void AppendCollapsed(StringRef Message, std::string& Out);
+
+} // namespace ntcode
@@ -18,14 +18,24 @@
 
 #pragma once
 
+#include "Profile.hpp"
+#include "Strategy.hpp"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include <array>
+#include <memory>
+#include <optional>
+#include <set>
 
 using llvm::StringRef;
+struct GroupEmitter;
 
 enum class StatusGroup : uint8_t {
   SUCCESS   = 0x0,    // 0x0NNN...
@@ -75,33 +85,206 @@ struct NtStatus {
   StringRef Message;
 };
 
+/// Where an entry's name and message sit in the source buffer.
+struct StatusStrings {
+  uint32_t NameOff, MsgOff;
+  uint16_t NameLen, MsgLen;
+};
+
+/// The parallel arrays behind a `StatusSpan`.
+struct StatusColumns {
+  const char* Source = nullptr;
+  const uint32_t* Keys = nullptr;
+  const StatusStrings* Strings = nullptr;
+public:
+  bool operator==(const StatusColumns&) const = default;
+};
+
+/// A run of entries in a `StatusTable`. Elements are `NtStatus`
+/// values built on access, code-only passes should use `keys()`.
+class StatusSpan : public llvm::indexed_accessor_range<
+   StatusSpan, StatusColumns, NtStatus, NtStatus, NtStatus> {
+public:
+  using indexed_accessor_range::indexed_accessor_range;
+  StatusSpan() : indexed_accessor_range(StatusColumns{}, 0, 0) { }
+
+  /// `(SG << 12) | Code` for each entry.
+  [[nodiscard]] llvm::ArrayRef<uint32_t> keys() const {
+    return {getBase().Keys + getStartIndex(), size()};
+  }
+  /// The facility of entry `Ix`, kept in its key.
+  [[nodiscard]] Subgroup subgroup(size_t Ix) const {
+    return Subgroup(keys()[Ix] >> (3 * 4));
+  }
+
+  static NtStatus dereference(const StatusColumns& Base, ptrdiff_t Ix);
+};
+
+/// A group's entries, stored column-wise: 16 bytes per entry where
+/// a `NtStatus` takes 40. Strings are offsets into the source buffer,
+/// which has to outlive the table.
+class StatusTable {
+public:
+  /// Longest name or message an entry can refer to.
+  static constexpr size_t MaxStringSize = UINT16_MAX;
+public:
+  /// Empties the table, and points it at a new source buffer.
+  void reset(StringRef Source);
+  /// Points the table at a copy of its source buffer.
+  void rebase(StringRef Source);
+  void reserve(size_t N);
+  /// `Status` must refer into the source buffer.
+  void push_back(const NtStatus& Status);
+  /// Copies entry `Ix` of `From`, which must share the source buffer.
+  void push_back(StatusSpan From, size_t Ix);
+  /// Points the table at `Source`, an edit of its source buffer that
+  /// only differs in `[Begin, End)`. Entries in that range are replaced
+  /// by `Statuses`, which refer into `Source`, and the ones after it
+  /// move along with the text.
+  void splice(StringRef Source, uint32_t Begin, uint32_t End,
+    llvm::ArrayRef<NtStatus> Statuses);
+
+  [[nodiscard]] size_t size() const { return this->packedKeys.size(); }
+  [[nodiscard]] bool empty() const { return this->packedKeys.empty(); }
+  [[nodiscard]] StringRef getSource() const { return this->source; }
+  [[nodiscard]] llvm::ArrayRef<uint32_t> keys() const {
+    return this->packedKeys;
+  }
+
+  operator StatusSpan() const {
+    return StatusSpan(StatusColumns {source.data(), packedKeys.data(),
+      strings.data()}, 0, size());
+  }
+  NtStatus operator[](size_t Ix) const { return StatusSpan(*this)[Ix]; }
+  auto begin() const { return StatusSpan(*this).begin(); }
+  auto end() const { return StatusSpan(*this).end(); }
+
+private:
+  StringRef source;
+  llvm::SmallVector<uint32_t, 0> packedKeys;
+  llvm::SmallVector<StatusStrings, 0> strings;
+};
+
 struct StatusCtx {
   StatusGroup Group;
   Subgroup SG;
 };
 
+/// The strategy picked for a group, or a facility of a large group.
+struct StrategyChoice {
+  StringRef Group;
+  std::optional<Subgroup> SG;
+  CodeDistribution Dist;
+  StrategyCost Cost;
+};
+
+/// Estimated size of a group, or one of its facilities, in the output.
+struct FootprintRow {
+  /// Assumed `sizeof(IOpaqueError)`: two strings plus group and extra.
+  static constexpr uint64_t EntryBytes = 32;
+  /// One code and two string offsets, in `EmitMode::Data`.
+  static constexpr uint64_t DataEntryBytes = 12;
+  /// One code and the offsets of both strings, in `EmitMode::Split`.
+  static constexpr uint64_t SplitEntryBytes = 12;
+  StringRef Group;
+  std::optional<Subgroup> SG;
+  size_t   Entries = 0;
+  size_t   SwitchCases = 0;
+  uint64_t TableBytes = 0;
+  uint64_t StringBytes = 0;
+  uint64_t UniqueStringBytes = 0;
+  /// Unique messages, only set in `EmitMode::Split`.
+  /// The other byte counts then leave them out.
+  uint64_t ColdBytes = 0;
+};
+
+/// Shape of the generated source.
+enum class EmitMode : uint8_t {
+  Code,   // A table and lookup function per group.
+  Data,   // Plain arrays and one shared lookup, no code per entry.
+  Split,  // Like `Data`, with messages apart from the lookup data.
+};
+
+enum class ReportFormat : uint8_t {
+  None,
+  Table,
+  JSON,
+};
+
+/// Settings for parsing and emission. Each parser has its own copy,
+/// so parsers with different settings can run side by side.
+struct ParserOptions {
+  /// Groups larger than this are split by facility.
+  size_t LargeGroupSize = 64;
+  /// Forces a lookup strategy, `Auto` leaves it to the cost model.
+  EmitStrategy StrategyOverride = EmitStrategy::Auto;
+  /// Adds `SysErr::RegisterFacility` for extending the catalog at runtime.
+  /// Registered codes and tables aren't copied, so callers must keep
+  /// them alive for the rest of the program.
+  bool EmitRegistry = false;
+  EmitMode Mode = EmitMode::Code;
+  /// Threads used to render groups, `0` uses every core.
+  unsigned EmitThreads = 0;
+public:
+  [[nodiscard]] bool isLargeGroup(StatusSpan Statuses) const {
+    return Statuses.size() > LargeGroupSize;
+  }
+  [[nodiscard]] const HitProfile& getHitProfile() const;
+  /// Puts hot entries first in their tables, and probes the hottest
+  /// before the general dispatch. The profile is shared between copies.
+  void setHitProfile(HitProfile Profile);
+  /// Hash of every setting that changes how a group renders.
+  [[nodiscard]] llvm::hash_code getGroupSettingsHash() const;
+
+private:
+  std::shared_ptr<const HitProfile> hitProfile;
+  llvm::hash_code hitProfileHash = 0;
+};
+
 struct NtCodeParser {
   using CodePair = std::pair<StatusGroup, NtStatus>;
-  using StatusGroupVec = llvm::SmallVector<NtStatus, 0>;
+  /// Where a parsed `<tr>` row sits in the input, in input order.
+  /// Rows outside the edited range of a new input are kept as they are.
+  struct RowEntry {
+    /// `GroupAndCode` of rows dropped as duplicates.
+    static constexpr uint32_t Duplicate = UINT32_MAX;
+    /// Offset of the row, and where the scan for the next one starts.
+    uint32_t RowOff, RowEnd;
+    uint32_t GroupAndCode;
+  };
+  using RowList = llvm::SmallVector<RowEntry, 0>;
+  using StatusGroupVec = StatusTable;
   /// Used to exclude subgroups in dumps.
   using SGExclusionSet = llvm::SmallSet<Subgroup, 4>;
+  using StrategyVec = llvm::SmallVector<StrategyChoice, 0>;
 public:
-  NtCodeParser(llvm::MemoryBufferRef MBRef) :
-   SPBuf(MBRef.getBuffer()), SPBufID(MBRef.getBufferIdentifier()) { }
+  NtCodeParser(llvm::MemoryBufferRef MBRef, ParserOptions Opts = {}) :
+   SPBuf(MBRef.getBuffer()), SPBufID(MBRef.getBufferIdentifier()),
+   opts(std::move(Opts)) { }
   
   static bool FindAndConsume(StringRef& Str, StringRef ToFind);
   static StringRef FindAndTake(StringRef& Str, StringRef ToFind);
   static StringRef GetSubgroupPrefix(Subgroup SG);
-  static bool IsLargeGroup(const StatusGroupVec& Statuses);
-  static size_t GetLargeGroupSize();
-  /// For tweaking the level of dispersal.
-  static void SetLargeGroupSize(size_t Size);
   static bool InStatusSubgroup(const NtStatus& Status);
 
+  /// Most IDs probed ahead of the general dispatch.
+  static constexpr size_t MaxHotCodes = 16;
+
   [[nodiscard]] bool parseFile();
+  /// Parses a new version of the input. Only the rows between the
+  /// parts it shares with the previous one are parsed, and spliced
+  /// into the groups in place of the rows they replace. `MBRef`
+  /// replaces the old buffer, which has to stay alive until this
+  /// returns. Inputs that had errors, and edits to rows whose code is
+  /// duplicated, are parsed in full.
+  [[nodiscard]] bool reparse(llvm::MemoryBufferRef MBRef);
   void dumpGroups(std::initializer_list<Subgroup> Exs = {}) const;
   void dumpGroups(const SGExclusionSet& Exclude) const;
+  void dumpStrategies() const;
+  /// Prints the estimated footprint of every group and facility.
+  void dumpFootprint(llvm::raw_ostream& OS, ReportFormat Format) const;
   [[nodiscard]] bool writeToFile(StringRef Filename, bool Debug = false);
+  [[nodiscard]] bool emitGroupData(llvm::raw_ostream& OS);
 
   [[nodiscard]] bool parseSuccessful() const { 
     return this->didParseSuccessfully;
@@ -109,12 +292,38 @@ public:
   [[nodiscard]] StringRef getBufferID() const {
     return this->SPBufID;
   }
+  [[nodiscard]] const ParserOptions& getOptions() const {
+    return this->opts;
+  }
+  /// Takes effect on the next emission; cached groups rendered with
+  /// other settings aren't reused.
+  void setOptions(ParserOptions Opts) {
+    this->opts = std::move(Opts);
+  }
+  [[nodiscard]] llvm::ArrayRef<std::string> getDiagnostics() const {
+    return this->diagnostics;
+  }
+  [[nodiscard]] const StatusGroupVec& getGroup(StatusGroup G) const;
+  [[nodiscard]] std::pair<size_t, size_t> getRowStats() const {
+    return {this->rowsParsed, this->rowsReused};
+  }
+  /// Groups that were rendered, rather than reused, by the last emission.
+  [[nodiscard]] llvm::ArrayRef<StringRef> getLastEmitted() const {
+    return this->lastEmitted;
+  }
 
 private:
   bool mapCodeGroup(StatusGroup G, NtStatus& Code);
   std::optional<StringRef> consumeNextSection();
+  std::optional<CodePair> parseRow(StringRef Row, RowList& Rows);
+  /// Splices the rows `Buffer` changed into the groups, or returns
+  /// false if it has to be parsed in full.
+  bool reparseChanged(StringRef Buffer);
   std::optional<CodePair> parseSection(StringRef Section);
-  bool emitGroupData(llvm::raw_ostream& OS);
+  void error(const llvm::Twine& Msg);
+  void emitCachedGroups(GroupEmitter& Emitter, bool IsDebug);
+  /// The hottest IDs of the catalog, hottest first.
+  llvm::SmallVector<uint32_t, 0> getHotCodes() const;
 
   void dumpGroup(StringRef GroupName, 
     const StatusGroupVec& Statuses, 
@@ -123,10 +332,36 @@ private:
 private:
   StringRef SPBuf;
   StringRef SPBufID;
+  ParserOptions opts;
   bool didParseSuccessfully = false;
 
   std::set<uint32_t> parsedValues;
   bool hadDuplicate = false;
+  StrategyVec strategies;
+  llvm::SmallVector<std::string, 0> diagnostics;
+
+  RowList rows;
+  /// The input `rows` refers to, which is still alive while the next
+  /// one is parsed. Only where the two differ is parsed again.
+  StringRef rowSource;
+  /// Codes of more than one row. Which row is kept depends on the
+  /// others, so edits to these rows are parsed in full.
+  std::set<uint32_t> duplicateValues;
+  size_t rowsParsed = 0;
+  size_t rowsReused = 0;
+
+  /// Rendered output of each group, reused while its entries and the
+  /// emission settings stay the same.
+  struct GroupCache {
+    llvm::hash_code Settings = 0;
+    /// The entries it was rendered from, compared in full on reuse.
+    std::string Contents;
+    bool IsValid = false;
+    std::string Text;
+    StrategyVec Strategies;
+  };
+  std::array<GroupCache, 4> groupCache;
+  llvm::SmallVector<StringRef, 4> lastEmitted;
 
   StatusGroupVec successes;
   StatusGroupVec infos;
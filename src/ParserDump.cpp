@@ -16,18 +16,18 @@
 //
 //===----------------------------------------------------------------===//
 
-#include "Parser.hpp"
+#include "Emitter.hpp"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/WithColor.h"
 
 using namespace llvm;
 
-static constinit size_t largeGroupSize = 64;
-
 static bool DoParserDump(const NtCodeParser* Parser);
 static void InsertExclusion(NtCodeParser::SGExclusionSet& Ex, Subgroup SG);
 static std::pair<StringRef, StringRef> GetSGPrefixRemoved(const NtStatus& Status);
 static WithColor GetColorRAII(const NtStatus& Status);
+static std::string GetTableName(StringRef Group, std::optional<Subgroup> SG);
 
 void NtCodeParser::dumpGroups(std::initializer_list<Subgroup> Exs) const {
   if (!DoParserDump(this))
@@ -51,7 +51,7 @@ void NtCodeParser::dumpGroup(
  StringRef GroupName, const StatusGroupVec& Statuses,
  const SGExclusionSet& Exclude) const {
   outs() << "Group<" << GroupName << ">" 
-    << (IsLargeGroup(Statuses) ? "" : "*")  << ": {\n";
+    << (opts.isLargeGroup(Statuses) ? "" : "*")  << ": {\n";
   for (const NtStatus& Status : Statuses) {
     if (Exclude.contains(Status.SG))
       continue;
@@ -65,18 +65,97 @@ void NtCodeParser::dumpGroup(
   outs() << "}\n\n";
 }
 
-//=== Statics ===//
+void NtCodeParser::dumpStrategies() const {
+  for (const StrategyChoice& Choice : strategies) {
+    const StrategyCost& Cost = Choice.Cost;
+    outs() << "Strategy<" << GetTableName(Choice.Group, Choice.SG) << ">: ";
+    WithColor(outs(), raw_ostream::YELLOW)
+      << strategy::GetName(Cost.Kind);
+    outs() << " (N: " << Choice.Dist.Count
+      << ", Span: " << Choice.Dist.span()
+      << ", Density: " << format("%.2f", Choice.Dist.density())
+      << ") ~" << Cost.Bytes << " bytes, "
+      << format("%.2f", Cost.Probes) << " probes"
+      << " (Max: " << Cost.MaxProbes << ")\n";
+  }
+}
+
+void NtCodeParser::dumpFootprint(
+ raw_ostream& OS, ReportFormat Format) const {
+  using enum StatusGroup;
+  if (Format == ReportFormat::None || !DoParserDump(this))
+    return;
+  GroupEmitter Emitter(nulls(), opts);
+  Emitter.report(SUCCESS, successes);
+  Emitter.report(INFO,    infos);
+  Emitter.report(WARNING, warnings);
+  Emitter.report(ERROR,   errors);
 
-bool NtCodeParser::IsLargeGroup(const StatusGroupVec& Statuses) {
-  return Statuses.size() > largeGroupSize;
+  const bool Split = (opts.Mode == EmitMode::Split);
+  SmallVector<FootprintRow, 0> Rows(
+    Emitter.getFootprint().begin(), Emitter.getFootprint().end());
+  std::stable_sort(Rows.begin(), Rows.end(),
+   [](const FootprintRow& L, const FootprintRow& R) {
+    return (L.TableBytes + L.UniqueStringBytes + L.ColdBytes)
+      > (R.TableBytes + R.UniqueStringBytes + R.ColdBytes);
+  });
+
+  if (Format == ReportFormat::JSON) {
+    json::OStream J(OS, 2);
+    J.array([&] {
+      for (const FootprintRow& Row : Rows) {
+        J.object([&] {
+          J.attribute("name", GetTableName(Row.Group, Row.SG));
+          J.attribute("entries", int64_t(Row.Entries));
+          J.attribute("switch_cases", int64_t(Row.SwitchCases));
+          J.attribute("table_bytes", int64_t(Row.TableBytes));
+          J.attribute("string_bytes", int64_t(Row.StringBytes));
+          J.attribute("unique_string_bytes", int64_t(Row.UniqueStringBytes));
+          if (Split)
+            J.attribute("cold_bytes", int64_t(Row.ColdBytes));
+        });
+      }
+    });
+    OS << '\n';
+    return;
+  }
+
+  OS << left_justify("Table", 20) << right_justify("Entries", 9)
+    << right_justify("Cases", 7) << right_justify("Table B", 10)
+    << right_justify("Strings B", 11) << right_justify("Unique B", 10);
+  if (Split)
+    OS << right_justify("Cold B", 10);
+  OS << '\n';
+  for (const FootprintRow& Row : Rows) {
+    OS << left_justify(GetTableName(Row.Group, Row.SG), 20)
+      << format_decimal(Row.Entries, 9)
+      << format_decimal(Row.SwitchCases, 7)
+      << format_decimal(Row.TableBytes, 10)
+      << format_decimal(Row.StringBytes, 11)
+      << format_decimal(Row.UniqueStringBytes, 10);
+    if (Split)
+      OS << format_decimal(Row.ColdBytes, 10);
+    OS << '\n';
+  }
 }
-size_t NtCodeParser::GetLargeGroupSize() {
-  return largeGroupSize;
+
+const HitProfile& ParserOptions::getHitProfile() const {
+  static const HitProfile Empty;
+  return hitProfile ? *hitProfile : Empty;
 }
-void NtCodeParser::SetLargeGroupSize(size_t Size) {
-  largeGroupSize = Size;
+
+void ParserOptions::setHitProfile(HitProfile Profile) {
+  hitProfileHash = Profile.hash();
+  hitProfile = std::make_shared<const HitProfile>(std::move(Profile));
 }
 
+hash_code ParserOptions::getGroupSettingsHash() const {
+  return hash_combine(LargeGroupSize,
+    StrategyOverride, Mode, hitProfileHash);
+}
+
+//=== Statics ===//
+
 bool NtCodeParser::InStatusSubgroup(const NtStatus& Status) {
   switch (Status.SG) {
    case Subgroup::DBG:  [[fallthrough]];
@@ -135,4 +214,14 @@ WithColor GetColorRAII(const NtStatus& Status) {
     Color = raw_ostream::YELLOW;
   
   return WithColor(outs(), Color);
-}
\ No newline at end of file
+}
+
+std::string GetTableName(StringRef Group, std::optional<Subgroup> SG) {
+  std::string Name = Group.str();
+  if (SG) {
+    raw_string_ostream(Name) << '.'
+      << NtCodeParser::GetSubgroupPrefix(*SG)
+      << format_hex_no_prefix(uint32_t(*SG), 3, true);
+  }
+  return Name;
+}
@@ -17,18 +17,36 @@
 //===----------------------------------------------------------------===//
 
 #include "Parser.hpp"
-#include "llvm/Support/Format.h"
-#include "llvm/Support/WithColor.h"
+#include "llvm/ADT/StringExtras.h"
+#include <cstring>
 
 using namespace llvm;
 
 static StatusGroup ConsumeStatusGroup(uint32_t& GroupAndCode);
 static StatusCtx   ConsumeStatusCtx(uint32_t& GroupAndCode);
+static size_t CommonPrefix(StringRef L, StringRef R);
+static size_t CommonSuffix(StringRef L, StringRef R);
 
 bool NtCodeParser::parseFile() {
   bool ParseSuccess = true;
+  rows.clear();
+  duplicateValues.clear();
+  rowsParsed = rowsReused = 0;
+  if (SPBuf.size() > UINT32_MAX) {
+    error("Input is too large.");
+    return false;
+  }
+  const StringRef Input = SPBuf;
+  rowSource = Input;
+  for (StatusGroupVec* Statuses : {&successes, &infos, &warnings, &errors}) {
+    // Most edits keep the group sizes.
+    const size_t Size = Statuses->size();
+    Statuses->reset(Input);
+    Statuses->reserve(Size);
+  }
+
   while (auto OSection = consumeNextSection()) {
-    auto OCode = parseSection(*OSection);
+    auto OCode = parseRow(*OSection, rows);
     if (!OCode) {
       if (!this->hadDuplicate)
         ParseSuccess = false;
@@ -40,33 +58,143 @@ bool NtCodeParser::parseFile() {
       ParseSuccess = false;
   }
 
+  rowsParsed = rows.size();
   this->didParseSuccessfully = ParseSuccess;
   return ParseSuccess;
 }
 
+bool NtCodeParser::reparse(llvm::MemoryBufferRef MBRef) {
+  const StringRef Buffer = MBRef.getBuffer();
+  SPBufID = MBRef.getBufferIdentifier();
+  hadDuplicate = false;
+  diagnostics.clear();
+  if (didParseSuccessfully && Buffer == rowSource) {
+    // Saved without changes: only the buffer moved.
+    SPBuf = Buffer.take_back(SPBuf.size());
+    for (StatusGroupVec* Statuses : {&successes, &infos, &warnings, &errors})
+      Statuses->rebase(Buffer);
+    rowSource = Buffer;
+    rowsParsed = 0;
+    rowsReused = rows.size();
+    return true;
+  }
+  if (didParseSuccessfully && Buffer.size() <= UINT32_MAX
+      && reparseChanged(Buffer))
+    return true;
+
+  SPBuf = Buffer;
+  parsedValues.clear();
+  hadDuplicate = false;
+  diagnostics.clear();
+  return parseFile();
+}
+
+bool NtCodeParser::reparseChanged(StringRef Buffer) {
+  const StringRef Old = rowSource;
+  const size_t Prefix = CommonPrefix(Old, Buffer);
+
+  // Rows ending before the edit are kept, and the scan for the next
+  // row starts where it did before.
+  auto First = partition_point(rows, [Prefix] (const RowEntry& R) {
+    return R.RowEnd <= Prefix;
+  });
+  const uint32_t ScanFrom = (First == rows.begin()) ? 0
+    : std::prev(First)->RowEnd;
+  // The shared end may take back what the prefix had past `ScanFrom`,
+  // so a row added in front of an identical one leaves it alone.
+  const size_t Suffix = CommonSuffix(Old.drop_front(ScanFrom),
+    Buffer.drop_front(ScanFrom));
+  const size_t SuffixStart = Buffer.size() - Suffix;
+  const int64_t Delta = int64_t(Buffer.size()) - int64_t(Old.size());
+
+  // Scan the new rows until the scan is past the edit, and at a point
+  // the old scan went through, from which both find the same rows.
+  const size_t OldTail = SPBuf.size();
+  SPBuf = Buffer.drop_front(ScanFrom);
+  SmallVector<StringRef, 4> Sections;
+  auto Last = rows.end();
+  for (;;) {
+    const size_t Pos = SPBuf.data() - Buffer.data();
+    if (Pos >= SuffixStart) {
+      const auto OldPos = uint64_t(int64_t(Pos) - Delta);
+      auto Next = std::partition_point(First, rows.end(),
+        [OldPos] (const RowEntry& R) { return R.RowOff < OldPos; });
+      const uint32_t PrevEnd = (Next == rows.begin()) ? 0
+        : std::prev(Next)->RowEnd;
+      if (PrevEnd <= OldPos) {
+        Last = Next;
+        break;
+      }
+    }
+    auto OSection = consumeNextSection();
+    if (!OSection)
+      break;
+    Sections.push_back(*OSection);
+  }
+  if (Last != rows.end())
+    SPBuf = Buffer.take_back(OldTail);
+
+  const uint32_t OldBegin = ScanFrom;
+  const uint32_t OldEnd = (Last == rows.end()) ? uint32_t(Old.size())
+    : Last->RowOff;
+  for (const RowEntry& R : make_range(First, Last)) {
+    if (R.GroupAndCode == RowEntry::Duplicate
+        || duplicateValues.contains(R.GroupAndCode))
+      return false;
+  }
+  for (const RowEntry& R : make_range(First, Last))
+    parsedValues.erase(R.GroupAndCode);
+
+  rowSource = Buffer;
+  RowList NewRows;
+  SmallVector<NtStatus, 4> NewStatuses[4];
+  for (StringRef Section : Sections) {
+    auto OCode = parseRow(Section, NewRows);
+    if (!OCode)
+      return false;
+    auto& [G, Status] = *OCode;
+    if (uint32_t(G) & 0x3)
+      return false;
+    NewStatuses[uint32_t(G) >> 2].push_back(Status);
+  }
+
+  // Offsets after the edit move with it, everything else is untouched.
+  successes.splice(Buffer, OldBegin, OldEnd, NewStatuses[0]);
+  infos.splice(Buffer, OldBegin, OldEnd, NewStatuses[1]);
+  warnings.splice(Buffer, OldBegin, OldEnd, NewStatuses[2]);
+  errors.splice(Buffer, OldBegin, OldEnd, NewStatuses[3]);
+  for (RowEntry& R : make_range(Last, rows.end())) {
+    R.RowOff += uint32_t(Delta);
+    R.RowEnd += uint32_t(Delta);
+  }
+  const auto At = rows.erase(First, Last);
+  rows.insert(At, NewRows.begin(), NewRows.end());
+  rowsParsed = NewRows.size();
+  rowsReused = rows.size() - NewRows.size();
+  return true;
+}
+
 bool NtCodeParser::mapCodeGroup(StatusGroup Group, NtStatus& Code) {
   switch (Group) {
    case StatusGroup::SUCCESS: {
-    successes.emplace_back(Code);
+    successes.push_back(Code);
     break;
    }
    case StatusGroup::INFO: {
-    infos.emplace_back(Code);
+    infos.push_back(Code);
     break;
    }
    case StatusGroup::WARNING: {
-    warnings.emplace_back(Code);
+    warnings.push_back(Code);
     break;
    }
    case StatusGroup::ERROR: {
-    errors.emplace_back(Code);
+    errors.push_back(Code);
     break;
    }
    default: {
-    WithColor::error();
     const auto GroupID = static_cast<uint8_t>(Group);
-    errs() << "Invalid CodeGroup: "
-      << llvm::format_hex(GroupID, 4, true) << ".\n";
+    error("Invalid CodeGroup: 0x" + utohexstr(GroupID, false, 2) + ".");
     return false;
    }
   }
@@ -74,6 +202,92 @@ bool NtCodeParser::mapCodeGroup(StatusGroup Group, NtStatus& Code) {
   return true;
 }
 
+const NtCodeParser::StatusGroupVec&
+ NtCodeParser::getGroup(StatusGroup Group) const {
+  switch (Group) {
+   case StatusGroup::SUCCESS: return successes;
+   case StatusGroup::INFO:    return infos;
+   case StatusGroup::WARNING: return warnings;
+   default:                   return errors;
+  }
+}
+
+void StatusTable::reset(StringRef Source) {
+  this->source = Source;
+  packedKeys.clear();
+  strings.clear();
+}
+
+void StatusTable::rebase(StringRef Source) {
+  assert(Source.size() == source.size() && "Source isn't a copy!");
+  this->source = Source;
+}
+
+void StatusTable::reserve(size_t N) {
+  packedKeys.reserve(N);
+  strings.reserve(N);
+}
+
+void StatusTable::push_back(const NtStatus& Status) {
+  auto Offset = [this] (StringRef Str) {
+    assert(Str.data() >= source.begin() && Str.end() <= source.end()
+      && "String is outside of the source buffer!");
+    return uint32_t(Str.data() - source.data());
+  };
+  packedKeys.push_back((uint32_t(Status.SG) << (3 * 4)) | Status.Code);
+  strings.push_back(StatusStrings {
+    .NameOff = Offset(Status.Name),
+    .MsgOff  = Offset(Status.Message),
+    .NameLen = uint16_t(Status.Name.size()),
+    .MsgLen  = uint16_t(Status.Message.size())
+  });
+}
+
+void StatusTable::splice(StringRef Source, uint32_t Begin, uint32_t End,
+ ArrayRef<NtStatus> Statuses) {
+  // Entries are in input order, so their names are too.
+  auto Before = [] (const StatusStrings& S, uint32_t Off) {
+    return S.NameOff < Off;
+  };
+  const size_t From = lower_bound(strings, Begin, Before) - strings.begin();
+  const size_t To = lower_bound(strings, End, Before) - strings.begin();
+  const auto Shift = uint32_t(Source.size() - source.size());
+  for (StatusStrings& S : make_range(strings.begin() + To, strings.end())) {
+    S.NameOff += Shift;
+    S.MsgOff += Shift;
+  }
+
+  StatusTable Inserted;
+  Inserted.reset(Source);
+  Inserted.reserve(Statuses.size());
+  for (const NtStatus& Status : Statuses)
+    Inserted.push_back(Status);
+  this->source = Source;
+  packedKeys.insert(packedKeys.erase(packedKeys.begin() + From,
+    packedKeys.begin() + To), Inserted.packedKeys.begin(),
+    Inserted.packedKeys.end());
+  strings.insert(strings.erase(strings.begin() + From,
+    strings.begin() + To), Inserted.strings.begin(), Inserted.strings.end());
+}
+
+void StatusTable::push_back(StatusSpan From, size_t Ix) {
+  assert(From.getBase().Source == source.data()
+    && "Tables have different sources!");
+  packedKeys.push_back(From.keys()[Ix]);
+  strings.push_back(From.getBase().Strings[From.getStartIndex() + Ix]);
+}
+
+NtStatus StatusSpan::dereference(
+ const StatusColumns& Base, ptrdiff_t Ix) {
+  const StatusStrings& Strings = Base.Strings[Ix];
+  return NtStatus {
+    .Code = Base.Keys[Ix] & 0xFFF,
+    .SG = Subgroup(Base.Keys[Ix] >> (3 * 4)),
+    .Name = StringRef(Base.Source + Strings.NameOff, Strings.NameLen),
+    .Message = StringRef(Base.Source + Strings.MsgOff, Strings.MsgLen)
+  };
+}
+
 std::optional<StringRef> NtCodeParser::consumeNextSection() {
   constexpr size_t npos = StringRef::npos;
   const size_t Beg = SPBuf.find("<tr>");
@@ -85,25 +299,48 @@ std::optional<StringRef> NtCodeParser::consumeNextSection() {
   return std::nullopt;
 }
 
+std::optional<NtCodeParser::CodePair>
+ NtCodeParser::parseRow(StringRef Row, RowList& Rows) {
+  const auto RowOff = uint32_t(Row.data() - rowSource.data());
+  const auto RowEnd = RowOff + uint32_t(Row.size() + StringRef("</tr>").size());
+  auto OCode = parseSection(Row);
+  if (!OCode) {
+    // Bad rows fail the whole parse, so only duplicates are kept.
+    if (this->hadDuplicate)
+      Rows.push_back(RowEntry {
+        .RowOff = RowOff,
+        .RowEnd = RowEnd,
+        .GroupAndCode = RowEntry::Duplicate
+      });
+    return std::nullopt;
+  }
+
+  const auto& [G, Status] = *OCode;
+  Rows.push_back(RowEntry {
+    .RowOff = RowOff,
+    .RowEnd = RowEnd,
+    .GroupAndCode = (uint32_t(G) << (7 * 4))
+      | (uint32_t(Status.SG) << (3 * 4)) | Status.Code
+  });
+  return OCode;
+}
+
 std::optional<NtCodeParser::CodePair>
  NtCodeParser::parseSection(StringRef Section) {
-  auto Err = [&Section] (StringRef Prefix, StringRef End = "</p>") {
-    WithColor::error();
+  auto Err = [this, &Section] (StringRef Prefix, StringRef End = "</p>") {
     const size_t EndPos = Section.find(End);
     if (EndPos == StringRef::npos) {
-      errs() << Prefix << ".\n";
+      error(Prefix + ".");
       return;
     }
-    errs() << Prefix << ": " 
-      << Section.take_front(EndPos) << ".\n";
+    error(Prefix + ": " + Section.take_front(EndPos) + ".");
   };
 
   NtStatus Status;
   StatusGroup Group;
 
   if (!FindAndConsume(Section, "<p>")) {
-    WithColor::error();
-    errs() << "Couldn't locate status code.\n";
+    error("Couldn't locate status code.");
     return std::nullopt;
   }
   Section.consume_front("0x");
@@ -115,6 +352,7 @@ std::optional<NtCodeParser::CodePair>
   }
 
   if (parsedValues.contains(GroupAndCode)) {
+    duplicateValues.insert(GroupAndCode);
     this->hadDuplicate = true;
     return std::nullopt;
   }
@@ -126,21 +364,18 @@ std::optional<NtCodeParser::CodePair>
   Status.SG   = Ctx.SG;
 
   if (GetSubgroupPrefix(Ctx.SG).empty()) {
-    WithColor::error();
-    errs() << "Invalid subgroup.\n";
+    error("Invalid subgroup.");
     return std::nullopt;
   }
 
   if (!FindAndConsume(Section, "<p>")) {
-    WithColor::error();
-    errs() << "Couldn't locate status name.\n";
+    error("Couldn't locate status name.");
     return std::nullopt;
   }
 
   const size_t NameEnd = Section.find("</p>");
   if (NameEnd == StringRef::npos) {
-    WithColor::error();
-    errs() << "Couldn't locate status name end.\n";
+    error("Couldn't locate status name end.");
     return std::nullopt;
   }
   Status.Name = Section.take_front(NameEnd);
@@ -148,21 +383,28 @@ std::optional<NtCodeParser::CodePair>
   Section.consume_front("</p>");
   
   if (!FindAndConsume(Section, "<p>")) {
-    WithColor::error();
-    errs() << "Couldn't locate status message.\n";
+    error("Couldn't locate status message.");
     return std::nullopt;
   }
   
   const size_t MsgEnd = Section.find("</p>");
   if (MsgEnd == StringRef::npos) {
-    WithColor::error();
-    errs() << "Couldn't locate status message end.\n";
+    error("Couldn't locate status message end.");
     return std::nullopt;
   }
   Status.Message = Section.take_front(MsgEnd);
+  if (std::max(Status.Name.size(), Status.Message.size())
+      > StatusTable::MaxStringSize) {
+    error("Status " + Status.Name.take_front(64) + " is too long.");
+    return std::nullopt;
+  }
   return {{Group, Status}};
 }
 
+void NtCodeParser::error(const Twine& Msg) {
+  diagnostics.push_back(Msg.str());
+}
+
 //=== Statics ===//
 
 bool NtCodeParser::FindAndConsume(StringRef& Str, StringRef ToFind) {
@@ -229,3 +471,29 @@ StatusCtx ConsumeStatusCtx(uint32_t& GroupAndCode) {
   auto SG = static_cast<Subgroup>(RawSG >> (3 * 4));
   return {G, SG};
 }
+
+size_t CommonPrefix(StringRef L, StringRef R) {
+  // Whole blocks are compared with `memcmp`, most of the input is shared.
+  constexpr size_t Block = 4096;
+  const size_t Size = std::min(L.size(), R.size());
+  size_t Off = 0;
+  while (Off + Block <= Size && !memcmp(L.data() + Off, R.data() + Off, Block))
+    Off += Block;
+  while (Off < Size && L[Off] == R[Off])
+    ++Off;
+  return Off;
+}
+
+size_t CommonSuffix(StringRef L, StringRef R) {
+  constexpr size_t Block = 4096;
+  const size_t Size = std::min(L.size(), R.size());
+  const char* const LEnd = L.end();
+  const char* const REnd = R.end();
+  size_t Len = 0;
+  while (Len + Block <= Size
+         && !memcmp(LEnd - Len - Block, REnd - Len - Block, Block))
+    Len += Block;
+  while (Len < Size && LEnd[-1 - ptrdiff_t(Len)] == REnd[-1 - ptrdiff_t(Len)])
+    ++Len;
+  return Len;
+}
@@ -18,19 +18,50 @@
 
 #include "Emitter.hpp"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FileSystem.h"
-#include "llvm/Support/WithColor.h"
+#include "llvm/Support/FileUtilities.h"
 
 using namespace llvm;
 
-static bool MakePathWithExtension(SmallVectorImpl<char>& Out, StringRef Ext);
-static bool PrintErrorCode(const std::error_code& EC, StringRef Msg = "");
+static Error MakePathWithExtension(SmallVectorImpl<char>& Out, StringRef Ext);
+static Error WriteIfChanged(StringRef Filename, StringRef Data);
+static void AppendContents(StatusSpan Statuses, std::string& Out);
+
+/// Multiplicative hash placing every hot code in a slot of its own.
+struct HotLayout {
+  /// The code in each slot, or `HashLayout::Empty`.
+  SmallVector<uint32_t, 0> Keys;
+  uint32_t Multiplier = 0;
+  unsigned Shift = 0;
+};
+static std::optional<HotLayout> BuildHotLayout(ArrayRef<uint32_t> Codes);
 
 static constexpr char EmitHeader[] =
 R"~(/* Autogenerated, DO NOT MODIFY! */
 
 #include <Sys/OpaqueError.hpp>
+#include <algorithm>
+#include <span>
+)~";
+
+static constexpr char EmitDataIncludes[] =
+R"~(#include <iterator>
+#include <new>
+)~";
+
+static constexpr char EmitRegistryIncludes[] =
+R"~(#include <atomic>
+#include <mutex>
+)~";
 
+/// Only what split mode needs when the registry isn't emitted.
+static constexpr char EmitSplitIncludes[] =
+R"~(#include <atomic>
+)~";
+
+static constexpr char EmitPrelude[] =
+R"~(
 #define $NewPErr(val, msg) \
  $NewOpqErr(ErrorGroup::OSError, val, msg, \
   OpqErrorExtra {.severity = ErrorSeverity::CURR_SEVERITY})
@@ -40,13 +71,99 @@ using namespace hc::sys;
 
 namespace {
 
+/// IDs handled per round of `GetOpaqueErrorBatch`.
+inline constexpr size_t $BatchBlock = 256;
+
+template <size_t N>
+constexpr int $FindSorted(const uint32_t(&keys)[N], OpqErrorID ID) {
+  const uint32_t* base = keys;
+  size_t len = N;
+  while (len > 1) {
+    const size_t half = len / 2;
+    base = (base[half] <= uint32_t(ID)) ? base + half : base;
+    len -= half;
+  }
+  return (*base == uint32_t(ID)) ? int(base - keys) : -1;
+}
+
+template <size_t N>
+constexpr int $FindHashed(const uint32_t(&keys)[N], OpqErrorID ID, unsigned shift) {
+  static_assert((N & (N - 1)) == 0, "Capacity must be a power of 2.");
+  uint32_t slot = (uint32_t(ID) * 0x9E3779B1u) >> shift;
+  while (keys[slot] != uint32_t(ID)) {
+    if (keys[slot] == 0xFFFFFFFF)
+      return -1;
+    slot = (slot + 1) & (N - 1);
+  }
+  return int(slot);
+}
+
 )~";
 
-static constexpr char EmitFooter[] =
-R"~(
-} // namespace `anonymous`
+static constexpr char EmitRegistry[] =
+R"~(/// Tables registered at runtime, for facilities that aren't in the
+/// generated catalog. Lookups are two acquire loads and a binary
+/// search; only registration takes the lock. Published tables are
+/// never freed, since readers may still be using them.
+struct $Registry {
+  struct Facility {
+    const uint32_t* codes;
+    const IOpaqueError* table;
+    size_t size;
+  };
+  using Slot = std::atomic<const Facility*>;
+  struct Leaf { Slot slots[256] {}; };
 
-OpaqueError SysErr::GetOpaqueError(OpqErrorID ID) {
+  /// [Severity][High byte of the subgroup] -> low byte of the subgroup.
+  static inline std::atomic<Leaf*> directory[16][256] {};
+  static inline std::mutex writeLock;
+
+  static OpaqueError Find(OpqErrorID ID) {
+    const uint32_t sg = (uint32_t(ID) >> 12) & 0xFFFF;
+    Leaf* leaf = directory[uint32_t(ID) >> 28][sg >> 8]
+      .load(std::memory_order_acquire);
+    if (!leaf)
+      return nullptr;
+    const Facility* F = leaf->slots[sg & 0xFF]
+      .load(std::memory_order_acquire);
+    if (!F)
+      return nullptr;
+    const uint32_t code = uint32_t(ID) & 0xFFF;
+    const uint32_t* it = std::lower_bound(F->codes, F->codes + F->size, code);
+    if (it == F->codes + F->size || *it != code)
+      return nullptr;
+    return &F->table[it - F->codes];
+  }
+
+  /// Keeps pointers into `Codes` and `Table`, not copies, so both
+  /// must outlive every lookup, e.g. by being static arrays.
+  static bool Register(OpqErrorID Prefix,
+   std::span<const uint32_t> Codes, std::span<const IOpaqueError> Table) {
+    if (Codes.size() != Table.size() || (uint32_t(Prefix) & 0xFFF))
+      return false;
+    if (!std::is_sorted(Codes.begin(), Codes.end()) ||
+        (!Codes.empty() && Codes.back() > 0xFFF))
+      return false;
+    const uint32_t sg = (uint32_t(Prefix) >> 12) & 0xFFFF;
+    auto& entry = directory[uint32_t(Prefix) >> 28][sg >> 8];
+
+    std::lock_guard<std::mutex> lock(writeLock);
+    Leaf* leaf = entry.load(std::memory_order_relaxed);
+    if (!leaf) {
+      leaf = new Leaf;
+      entry.store(leaf, std::memory_order_release);
+    }
+    auto* F = new Facility {Codes.data(), Table.data(), Codes.size()};
+    leaf->slots[sg & 0xFF].store(F, std::memory_order_release);
+    return true;
+  }
+};
+
+)~";
+
+static constexpr char EmitDispatch[] =
+R"~(
+constexpr OpaqueError $GetBuiltin(OpqErrorID ID) {
   const OpqErrorID base = (ID & 0x0FFFFFFF);
   switch (ID & 0xF0000000) {
    case 0x00000000:
@@ -61,7 +178,291 @@ OpaqueError SysErr::GetOpaqueError(OpqErrorID ID) {
     return nullptr;
   }
 }
-)~"; 
+
+void $GetBuiltinBatch(
+ std::span<const OpqErrorID> IDs, std::span<OpaqueError> Out) {
+  const size_t count = std::min(IDs.size(), Out.size());
+  // One bucket per group, plus one for invalid severities.
+  uint16_t bucket[5][$BatchBlock];
+  for (size_t off = 0; off < count; off += $BatchBlock) {
+    const size_t n = std::min(count - off, $BatchBlock);
+    const OpqErrorID* ids = IDs.data() + off;
+    OpaqueError* out = Out.data() + off;
+    size_t sizes[5] {};
+    for (size_t i = 0; i < n; ++i) {
+      const uint32_t sev = uint32_t(ids[i]) >> 28;
+      // Only 0x0, 0x4, 0x8 and 0xC are valid severities.
+      const uint32_t g = (sev & 0x3) ? 4 : (sev >> 2);
+      bucket[g][sizes[g]++] = uint16_t(i);
+    }
+    _SuccessGroup::GetBatch(ids, bucket[0], sizes[0], out);
+    _InfoGroup::GetBatch(ids, bucket[1], sizes[1], out);
+    _WarningGroup::GetBatch(ids, bucket[2], sizes[2], out);
+    _ErrorGroup::GetBatch(ids, bucket[3], sizes[3], out);
+    for (size_t i = 0; i < sizes[4]; ++i)
+      out[bucket[4][i]] = nullptr;
+  }
+}
+
+} // namespace `anonymous`
+)~";
+
+static constexpr char EmitSplitPrelude[] =
+R"~(#if defined(__ELF__)
+# define $ColdData [[gnu::section(".rodata.cold")]]
+#else
+# define $ColdData
+#endif
+
+)~";
+
+static constexpr char EmitDataEntries[] =
+R"~(
+/// Entries are built on first use, so the catalog needs no code
+/// per entry; `$Catalog` is plain data.
+const IOpaqueError* $Entries() {
+  static constexpr ErrorSeverity severities[] {
+    ErrorSeverity::Success, ErrorSeverity::Info,
+    ErrorSeverity::Warning, ErrorSeverity::Error,
+  };
+  constexpr size_t count = std::size($Catalog::codes);
+  alignas(IOpaqueError) static unsigned char storage[
+    sizeof(IOpaqueError) * count];
+  static const IOpaqueError* const entries = [] {
+    auto* out = reinterpret_cast<IOpaqueError*>(storage);
+    for (size_t i = 0; i < count; ++i) {
+      const char* name = $Catalog::strings + $Catalog::index[2 * i];
+      const char* msg = $Catalog::strings + $Catalog::index[2 * i + 1];
+      const auto sev = severities[$Catalog::codes[i] >> 30];
+      ::new (out + i) IOpaqueError($NewOpqErr(ErrorGroup::OSError,
+        name, msg, OpqErrorExtra {.severity = sev}));
+    }
+    return out;
+  }();
+  return entries;
+}
+
+)~";
+
+static constexpr char EmitSplitEntries[] =
+R"~(
+/// Each entry is built on its first lookup. Its message only points
+/// into `$Cold`, which is read once a caller reads the message.
+const IOpaqueError* $Entry(size_t i) {
+  static constexpr ErrorSeverity severities[] {
+    ErrorSeverity::Success, ErrorSeverity::Info,
+    ErrorSeverity::Warning, ErrorSeverity::Error,
+  };
+  enum : uint8_t { Unbuilt, Building, Built };
+  constexpr size_t count = std::size($Catalog::codes);
+  alignas(IOpaqueError) static unsigned char storage[
+    sizeof(IOpaqueError) * count];
+  static std::atomic<uint8_t> states[count];
+
+  auto* const out = reinterpret_cast<IOpaqueError*>(storage) + i;
+  uint8_t state = states[i].load(std::memory_order_acquire);
+  if (state == Built)
+    return out;
+  if (state == Unbuilt && states[i].compare_exchange_strong(
+      state, Building, std::memory_order_acquire)) {
+    const char* name = $Catalog::strings + $Catalog::names[i];
+    const char* msg = $Cold::strings + $Catalog::messages[i];
+    const auto sev = severities[$Catalog::codes[i] >> 30];
+    ::new (out) IOpaqueError($NewOpqErr(ErrorGroup::OSError,
+      name, msg, OpqErrorExtra {.severity = sev}));
+    states[i].store(Built, std::memory_order_release);
+    states[i].notify_all();
+    return out;
+  }
+  // Another thread is building it.
+  states[i].wait(Building, std::memory_order_acquire);
+  return out;
+}
+
+)~";
+
+static constexpr char EmitDataLookup[] =
+R"~(OpaqueError $GetBuiltin(OpqErrorID ID) {
+  const int pos = $FindSorted($Catalog::codes, ID);
+  return (pos < 0) ? nullptr : &$Entries()[pos];
+}
+
+void $GetBuiltinBatch(
+ std::span<const OpqErrorID> IDs, std::span<OpaqueError> Out) {
+  const size_t count = std::min(IDs.size(), Out.size());
+  const IOpaqueError* entries = $Entries();
+  for (size_t i = 0; i < count; ++i) {
+    const int pos = $FindSorted($Catalog::codes, IDs[i]);
+    Out[i] = (pos < 0) ? nullptr : &entries[pos];
+  }
+}
+
+} // namespace `anonymous`
+)~";
+
+static constexpr char EmitSplitLookup[] =
+R"~(OpaqueError $GetBuiltin(OpqErrorID ID) {
+  const int pos = $FindSorted($Catalog::codes, ID);
+  return (pos < 0) ? nullptr : $Entry(pos);
+}
+
+void $GetBuiltinBatch(
+ std::span<const OpqErrorID> IDs, std::span<OpaqueError> Out) {
+  const size_t count = std::min(IDs.size(), Out.size());
+  for (size_t i = 0; i < count; ++i) {
+    const int pos = $FindSorted($Catalog::codes, IDs[i]);
+    Out[i] = (pos < 0) ? nullptr : $Entry(pos);
+  }
+}
+
+} // namespace `anonymous`
+)~";
+
+static constexpr char EmitSplitAccessor[] =
+R"~(
+namespace hc::sys {
+
+const char* GetOpaqueErrorName(OpqErrorID ID) {
+  const int pos = $FindSorted($Catalog::codes, ID);
+  return (pos < 0) ? nullptr : $Catalog::strings + $Catalog::names[pos];
+}
+
+} // namespace hc::sys
+)~";
+
+/// Declares what split mode defines beyond <Sys/OpaqueError.hpp>.
+static constexpr char EmitSplitDecls[] =
+R"~(/* Autogenerated, DO NOT MODIFY! */
+
+#pragma once
+
+#include <Sys/OpaqueError.hpp>
+
+namespace hc::sys {
+
+/// Name of `ID`, without building its entry or reading its message.
+/// Null if it isn't built in.
+const char* GetOpaqueErrorName(OpqErrorID ID);
+
+} // namespace hc::sys
+)~";
+
+static constexpr char EmitEmptyLookup[] =
+R"~(/// The catalog is empty, so nothing is built in.
+OpaqueError $GetBuiltin(OpqErrorID) {
+  return nullptr;
+}
+
+void $GetBuiltinBatch(
+ std::span<const OpqErrorID> IDs, std::span<OpaqueError> Out) {
+  std::fill_n(Out.begin(), std::min(IDs.size(), Out.size()), nullptr);
+}
+
+} // namespace `anonymous`
+)~";
+
+static constexpr char EmitEmptyAccessor[] =
+R"~(
+namespace hc::sys {
+
+const char* GetOpaqueErrorName(OpqErrorID) {
+  return nullptr;
+}
+
+} // namespace hc::sys
+)~";
+
+static constexpr char EmitHotIncludes[] =
+R"~(#include <array>
+)~";
+
+static constexpr char EmitHotHead[] =
+R"~(
+namespace {
+
+/// The hottest IDs of the profile, probed before the general dispatch.
+/// Each one has a slot of its own, so a probe is a single compare.
+struct $Hot {
+)~";
+
+static constexpr char EmitHotEntries[] =
+R"~(  /// Resolved at compile time, so there is nothing to initialize.
+  static constexpr std::array<OpaqueError, std::size(keys)> entries = [] {
+    std::array<OpaqueError, std::size(keys)> out {};
+    for (size_t i = 0; i < out.size(); ++i)
+      out[i] = $GetBuiltin(keys[i]);
+    return out;
+  }();
+
+)~";
+
+static constexpr char EmitHotPositions[] =
+R"~(  /// Positions in `$Catalog`, resolved at compile time.
+  static constexpr std::array<int, std::size(keys)> pos = [] {
+    std::array<int, std::size(keys)> out {};
+    for (size_t i = 0; i < out.size(); ++i)
+      out[i] = $FindSorted($Catalog::codes, keys[i]);
+    return out;
+  }();
+
+)~";
+
+static constexpr char EmitHotTail[] =
+R"~(};
+
+} // namespace `anonymous`
+)~";
+
+static constexpr char EmitGetHead[] =
+R"~(
+OpaqueError SysErr::GetOpaqueError(OpqErrorID ID) {
+)~";
+
+static constexpr char EmitHotProbe[] =
+R"~(  if (OpaqueError E = $Hot::Get(ID))
+    return E;
+)~";
+
+static constexpr char EmitGetBody[] =
+R"~(  return $GetBuiltin(ID);
+}
+)~";
+
+static constexpr char EmitRegistryGetBody[] =
+R"~(  if (OpaqueError E = $GetBuiltin(ID))
+    return E;
+  return $Registry::Find(ID);
+}
+)~";
+
+static constexpr char EmitFooter[] =
+R"~(
+void SysErr::GetOpaqueErrorBatch(
+ std::span<const OpqErrorID> IDs, std::span<OpaqueError> Out) {
+  $GetBuiltinBatch(IDs, Out);
+}
+)~";
+
+static constexpr char EmitRegistryFooter[] =
+R"~(
+void SysErr::GetOpaqueErrorBatch(
+ std::span<const OpqErrorID> IDs, std::span<OpaqueError> Out) {
+  $GetBuiltinBatch(IDs, Out);
+  const size_t count = std::min(IDs.size(), Out.size());
+  for (size_t i = 0; i < count; ++i) {
+    if (!Out[i])
+      Out[i] = $Registry::Find(IDs[i]);
+  }
+}
+
+/// Adds `Table`, indexed like the sorted `Codes`, as the facility of
+/// `Prefix`. Neither span is copied: both have to stay alive for as
+/// long as `GetOpaqueError` may be called, so pass static arrays.
+bool SysErr::RegisterFacility(OpqErrorID Prefix,
+ std::span<const uint32_t> Codes, std::span<const IOpaqueError> Table) {
+  return $Registry::Register(Prefix, Codes, Table);
+}
+)~";
 
 bool NtCodeParser::writeToFile(StringRef Filename, bool Debug) {
   using namespace llvm::sys;
@@ -69,59 +470,270 @@ bool NtCodeParser::writeToFile(StringRef Filename, bool Debug) {
     return emitGroupData(outs());
 
   SmallString<128> OutputCpp = Filename;
-  if (MakePathWithExtension(OutputCpp, "cpp"))
+  if (Error E = MakePathWithExtension(OutputCpp, "cpp")) {
+    error(toString(std::move(E)));
     return false;
+  }
   
-  std::error_code EC;
-  raw_fd_ostream OS {OutputCpp, EC};
-  if (PrintErrorCode(EC, "Error opening file"))
+  SmallString<0> Rendered;
+  raw_svector_ostream OS {Rendered};
+  if (!emitGroupData(OS))
+    return false;
+  if (Error E = WriteIfChanged(OutputCpp, Rendered)) {
+    error(toString(std::move(E)));
     return false;
-  return emitGroupData(OS);
+  }
+  if (opts.Mode != EmitMode::Split)
+    return true;
+
+  // `GetOpaqueErrorName` isn't in <Sys/OpaqueError.hpp>, so callers
+  // get its declaration from a header next to the source.
+  SmallString<128> OutputHpp = OutputCpp;
+  sys::path::replace_extension(OutputHpp, "hpp");
+  if (Error E = WriteIfChanged(OutputHpp, EmitSplitDecls)) {
+    error(toString(std::move(E)));
+    return false;
+  }
+  return true;
 }
 
 bool NtCodeParser::emitGroupData(raw_ostream& OS) {
   using enum StatusGroup;
-  GroupEmitter Emitter(OS);
+  GroupEmitter Emitter(OS, opts);
 
-  OS << EmitHeader << '\n';
-  Emitter.emit(SUCCESS, successes);
-  Emitter.emit(INFO,    infos);
-  Emitter.emit(WARNING, warnings);
-  Emitter.emit(ERROR,   errors);
-  OS << EmitFooter << '\n';
+  const bool Registry = opts.EmitRegistry;
+  const bool Split = (opts.Mode == EmitMode::Split);
+  const bool DataOnly = Split || (opts.Mode == EmitMode::Data);
+  const SmallVector<uint32_t, 0> HotCodes = getHotCodes();
+  OS << EmitHeader;
+  if (DataOnly)
+    OS << EmitDataIncludes;
+  if (!HotCodes.empty())
+    OS << EmitHotIncludes;
+  if (Registry)
+    OS << EmitRegistryIncludes;
+  else if (Split)
+    OS << EmitSplitIncludes;
+  OS << EmitPrelude << '\n';
+  if (Split)
+    OS << EmitSplitPrelude;
+  bool HasEntries = true;
+  if (DataOnly) {
+    HasEntries = Emitter.dataEmit({
+      {SUCCESS, successes},
+      {INFO,    infos},
+      {WARNING, warnings},
+      {ERROR,   errors}}, Split);
+    lastEmitted.assign({"Success", "Info", "Warning", "Error"});
+  } else {
+    emitCachedGroups(Emitter, OS.is_displayed());
+  }
+  if (Registry)
+    OS << EmitRegistry;
+  if (DataOnly && !HasEntries) {
+    OS << EmitEmptyLookup;
+    if (Split)
+      OS << EmitEmptyAccessor;
+  } else if (DataOnly) {
+    if (Split)
+      OS << EmitSplitEntries << EmitSplitLookup << EmitSplitAccessor;
+    else
+      OS << EmitDataEntries << EmitDataLookup;
+  } else {
+    OS << EmitDispatch;
+  }
+  if (!HotCodes.empty()) {
+    // Without a layout separating every hot code, the coldest ones
+    // are left to the general dispatch. A single code always fits.
+    std::optional<HotLayout> Layout;
+    for (ArrayRef<uint32_t> Hot = HotCodes; !Layout; Hot = Hot.drop_back())
+      Layout = BuildHotLayout(Hot);
+    OS << EmitHotHead;
+    Emitter.emitArray("uint32_t", "keys", Layout->Keys, true, 10);
+    OS << (DataOnly ? EmitHotPositions : EmitHotEntries);
+    OS.indent(2) << "static OpaqueError Get(OpqErrorID ID) {\n";
+    OS.indent(4) << "const uint32_t slot = (uint32_t(ID) * "
+      << format_hex(Layout->Multiplier, 10, true) << "u) >> "
+      << Layout->Shift << ";\n";
+    if (DataOnly) {
+      OS.indent(4) << "if (keys[slot] != uint32_t(ID) || pos[slot] < 0)\n";
+      OS.indent(6) << "return nullptr;\n";
+      OS.indent(4) << (Split ? "return $Entry(pos[slot]);\n"
+                             : "return &$Entries()[pos[slot]];\n");
+    } else {
+      OS.indent(4) << "return (keys[slot] == uint32_t(ID)) "
+        "? entries[slot] : nullptr;\n";
+    }
+    OS.indent(2) << "}\n";
+    OS << EmitHotTail;
+  }
+  OS << EmitGetHead;
+  if (!HotCodes.empty())
+    OS << EmitHotProbe;
+  OS << (Registry ? EmitRegistryGetBody : EmitGetBody);
+  OS << (Registry ? EmitRegistryFooter : EmitFooter) << '\n';
+  this->strategies.assign(
+    Emitter.getStrategies().begin(),
+    Emitter.getStrategies().end());
 
   if (!Emitter.emitSuccessful()) {
     ArrayRef<StringRef> Failures = Emitter.getFailures();
-    WithColor::error();
-    errs() << "Emmission failed on group[s]: {" << Failures[0];
-    for (StringRef Failure : Failures.drop_front())
-      errs() << ", " << Failure;
-    errs() << "}\n";
+    error("Emmission failed on group[s]: {"
+      + join(Failures, ", ") + "}");
     return false;
   }
   
   return true;
 }
 
+void NtCodeParser::emitCachedGroups(GroupEmitter& Emitter, bool IsDebug) {
+  using enum StatusGroup;
+  const std::pair<StatusGroup, const StatusGroupVec*> Groups[] {
+    {SUCCESS, &successes},
+    {INFO,    &infos},
+    {WARNING, &warnings},
+    {ERROR,   &errors},
+  };
+
+  // Groups whose entries didn't change since the last emission are
+  // spliced back in instead of being rendered again.
+  const hash_code Settings = hash_combine(opts.getGroupSettingsHash(), IsDebug);
+  std::string Contents[std::size(Groups)];
+  lastEmitted.clear();
+  for (size_t Ix = 0; Ix < std::size(Groups); ++Ix) {
+    auto [G, Statuses] = Groups[Ix];
+    AppendContents(*Statuses, Contents[Ix]);
+    const GroupCache& Cache = groupCache[Ix];
+    if (Cache.IsValid && Cache.Settings == Settings
+        && Cache.Contents == Contents[Ix]) {
+      Emitter.emitVerbatim(G, Cache.Text, Cache.Strategies);
+      continue;
+    }
+    Emitter.emit(G, *Statuses);
+    lastEmitted.push_back(GroupEmitter::GetGroupName(G));
+  }
+  Emitter.flush();
+
+  for (size_t Ix = 0; Ix < std::size(Groups); ++Ix) {
+    const StringRef Name = GroupEmitter::GetGroupName(Groups[Ix].first);
+    if (!is_contained(lastEmitted, Name))
+      continue;
+    GroupCache& Cache = groupCache[Ix];
+    Cache.Settings = Settings;
+    Cache.Contents = std::move(Contents[Ix]);
+    Cache.IsValid = !is_contained(Emitter.getFailures(), Name);
+    Cache.Text = Emitter.getRendered(Name).str();
+    Cache.Strategies.clear();
+    for (const StrategyChoice& Choice : Emitter.getStrategies()) {
+      if (Choice.Group == Name)
+        Cache.Strategies.push_back(Choice);
+    }
+  }
+}
+
+SmallVector<uint32_t, 0> NtCodeParser::getHotCodes() const {
+  using enum StatusGroup;
+  const HitProfile& Profile = opts.getHitProfile();
+  if (Profile.empty())
+    return {};
+
+  SmallVector<std::pair<uint64_t, uint32_t>, 0> Hot;
+  for (StatusGroup G : {SUCCESS, INFO, WARNING, ERROR}) {
+    const StatusGroupVec& Statuses = getGroup(G);
+    for (size_t Ix = 0; Ix < Statuses.size(); ++Ix) {
+      const uint32_t ID = (uint32_t(G) << (7 * 4)) | Statuses.keys()[Ix];
+      if (uint64_t Hits = Profile.lookup(ID, Statuses[Ix].Name))
+        Hot.emplace_back(Hits, ID);
+    }
+  }
+
+  // Hottest first, ties broken by ID so the output is stable.
+  llvm::sort(Hot, [](const auto& L, const auto& R) {
+    return (L.first != R.first) ? (L.first > R.first) : (L.second < R.second);
+  });
+  if (Hot.size() > MaxHotCodes)
+    Hot.truncate(MaxHotCodes);
+  SmallVector<uint32_t, 0> Codes;
+  for (auto [Hits, ID] : Hot)
+    Codes.push_back(ID);
+  return Codes;
+}
+
 //=== Statics ===//
 
-bool MakePathWithExtension(
+Error MakePathWithExtension(
  SmallVectorImpl<char>& Out, StringRef Ext) {
   using namespace llvm::sys;
   if (path::is_relative(Out)) {
     if (auto EC = fs::make_absolute(Out))
-      return PrintErrorCode(EC, "Error creating path");
+      return createStringError(EC, "Error creating path: " + EC.message());
   }
   path::replace_extension(Out, Ext);
-  return false;
+  return Error::success();
 }
 
-bool PrintErrorCode(const std::error_code& EC, StringRef Msg) {
-  if (!EC)
-    return false;
-  WithColor::error();
-  if (!Msg.empty())
-    errs() << Msg << ": ";
-  errs() << EC.message() << '\n';
-  return true;
-}
\ No newline at end of file
+Error WriteIfChanged(StringRef Filename, StringRef Data) {
+  // Leave the mtime alone when nothing changed, so dependents
+  // of the output don't get rebuilt.
+  if (auto Existing = MemoryBuffer::getFile(Filename)) {
+    if ((*Existing)->getBuffer() == Data)
+      return Error::success();
+  }
+
+  SmallString<128> TempModel = Filename;
+  TempModel += "-%%%%%%%%.tmp";
+  if (Error E = writeFileAtomically(TempModel, Filename, Data)) {
+    return createStringError(inconvertibleErrorCode(),
+      "Error writing \"" + Filename + "\": " + toString(std::move(E)));
+  }
+  return Error::success();
+}
+
+void AppendContents(StatusSpan Statuses, std::string& Out) {
+  // Strings go behind their lengths, so different entries can't
+  // run together into the same bytes.
+  auto AppendRaw = [&Out] (const auto& Value) {
+    Out.append(reinterpret_cast<const char*>(&Value), sizeof(Value));
+  };
+  for (size_t Ix = 0; Ix < Statuses.size(); ++Ix) {
+    const NtStatus Status = Statuses[Ix];
+    AppendRaw(Statuses.keys()[Ix]);
+    AppendRaw(uint32_t(Status.Name.size()));
+    AppendRaw(uint32_t(Status.Message.size()));
+    Out += Status.Name;
+    Out += Status.Message;
+  }
+}
+
+std::optional<HotLayout> BuildHotLayout(ArrayRef<uint32_t> Codes) {
+  // Odd multipliers are tried from the golden ratio on, doubling the
+  // table when none separates the codes, up to `MaxSlotsPerCode`.
+  constexpr unsigned MaxTries = 4096;
+  constexpr uint64_t MaxSlotsPerCode = 16;
+  HotLayout Layout;
+  const uint64_t MinCapacity =
+    PowerOf2Ceil(std::max<size_t>(Codes.size() * 2, 2));
+  const uint64_t MaxCapacity =
+    PowerOf2Ceil(std::max<size_t>(Codes.size() * MaxSlotsPerCode, 2));
+  assert(MaxCapacity <= (uint64_t(1) << 31) && "Shift must stay above 0.");
+  for (uint64_t Capacity = MinCapacity;
+       Capacity <= MaxCapacity; Capacity *= 2) {
+    Layout.Shift = 32 - Log2_64(Capacity);
+    uint32_t Multiplier = 0x9E3779B1u;
+    for (unsigned Try = 0; Try < MaxTries; ++Try, Multiplier += 2) {
+      Layout.Keys.assign(Capacity, HashLayout::Empty);
+      const bool Separated = all_of(Codes, [&] (uint32_t Code) {
+        uint32_t& Key = Layout.Keys[(Code * Multiplier) >> Layout.Shift];
+        if (Key != HashLayout::Empty)
+          return false;
+        Key = Code;
+        return true;
+      });
+      if (Separated) {
+        Layout.Multiplier = Multiplier;
+        return Layout;
+      }
+    }
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,78 @@
+//===- Profile.cpp --------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "Profile.hpp"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+
+using namespace llvm;
+
+Expected<HitProfile> HitProfile::parse(MemoryBufferRef MBRef) {
+  HitProfile Profile;
+  SmallVector<StringRef, 0> Lines;
+  MBRef.getBuffer().split(Lines, '\n');
+
+  for (size_t Ix = 0; Ix < Lines.size(); ++Ix) {
+    auto Err = [&] (const Twine& Msg) {
+      return createStringError(inconvertibleErrorCode(),
+        MBRef.getBufferIdentifier() + ":" + Twine(Ix + 1) + ": " + Msg);
+    };
+    const StringRef Line = Lines[Ix].trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+
+    SmallVector<StringRef, 2> Fields;
+    SplitString(Line, Fields, " \t,");
+    if (Fields.size() != 2)
+      return Err("expected `<code or name> <count>`.");
+
+    uint64_t Count;
+    if (Fields[1].getAsInteger(10, Count))
+      return Err("invalid count \"" + Fields[1] + "\".");
+
+    StringRef Key = Fields[0];
+    if (Key.consume_front("0x") || Key.consume_front("0X")) {
+      uint32_t ID;
+      if (Key.getAsInteger(16, ID))
+        return Err("invalid code \"" + Fields[0] + "\".");
+      Profile.IDCounts[ID] += Count;
+      continue;
+    }
+    Key.consume_front("STATUS_");
+    Profile.NameCounts[Key] += Count;
+  }
+  return Profile;
+}
+
+hash_code HitProfile::hash() const {
+  SmallVector<std::pair<uint32_t, uint64_t>, 0> IDs(
+    IDCounts.begin(), IDCounts.end());
+  SmallVector<std::pair<StringRef, uint64_t>, 0> Names;
+  for (const auto& Entry : NameCounts)
+    Names.emplace_back(Entry.first(), Entry.second);
+  sort(IDs);
+  sort(Names);
+
+  hash_code Hash = hash_combine(IDs.size(), Names.size());
+  for (auto [ID, Count] : IDs)
+    Hash = hash_combine(Hash, ID, Count);
+  for (auto [Name, Count] : Names)
+    Hash = hash_combine(Hash, Name, Count);
+  return Hash;
+}
@@ -0,0 +1,48 @@
+//===- Profile.hpp --------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+using llvm::StringRef;
+
+/// How often each status was looked up, e.g. counted from logs.
+/// Each line of the input is `<code or name> <count>`, where the code
+/// is hex and the `STATUS_` prefix of names is optional. Blank lines
+/// and lines starting with `#` are skipped.
+struct HitProfile {
+  llvm::DenseMap<uint32_t, uint64_t> IDCounts;
+  llvm::StringMap<uint64_t> NameCounts;
+public:
+  static llvm::Expected<HitProfile> parse(llvm::MemoryBufferRef MBRef);
+
+  [[nodiscard]] bool empty() const {
+    return IDCounts.empty() && NameCounts.empty();
+  }
+  /// Hits recorded for the status `ID`, named `Name`.
+  [[nodiscard]] uint64_t lookup(uint32_t ID, StringRef Name) const {
+    return IDCounts.lookup(ID) + NameCounts.lookup(Name);
+  }
+  /// Independent of the input's line order.
+  [[nodiscard]] llvm::hash_code hash() const;
+};
@@ -0,0 +1,357 @@
+//===- Search.cpp ---------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "Search.hpp"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileUtilities.h"
+
+using namespace llvm;
+using namespace ntcode;
+
+/// Serialized layout, all little endian:
+///   Magic, Version, InputHash, #Entries, #Keys, #Postings, #Pool,
+///   Entries, Keys, Starts (#Keys + 1), Postings, Pool.
+static constexpr StringLiteral IndexMagic = "NTTRIGRM";
+static constexpr uint32_t IndexVersion = 1;
+
+static void AppendNormalized(StringRef In, std::string& Out);
+static void GetTrigrams(StringRef Text, SmallVectorImpl<uint32_t>& Out);
+static Error MakeIndexError(const Twine& Msg);
+
+TrigramIndex TrigramIndex::build(const Catalog& C, uint64_t InputHash) {
+  using enum StatusGroup;
+  TrigramIndex Index;
+  Index.inputHash = InputHash;
+  std::string& Pool = Index.pool;
+
+  // (Trigram << 32) | Entry, sorted into postings afterwards.
+  SmallVector<uint64_t, 0> Pairs;
+  SmallVector<uint32_t, 64> Trigrams;
+  for (StatusGroup G : {SUCCESS, INFO, WARNING, ERROR}) {
+    for (const NtStatus& Status : C.getGroup(G)) {
+      Entry E;
+      E.ID = (uint32_t(G) << (7 * 4))
+        | (uint32_t(Status.SG) << (3 * 4)) | Status.Code;
+      E.NameOff = Pool.size();
+      Pool += Status.Name;
+      E.NameLen = Pool.size() - E.NameOff;
+      E.MsgOff = Pool.size();
+      AppendCollapsed(Status.Message, Pool);
+      E.MsgLen = Pool.size() - E.MsgOff;
+
+      // " name words \n message words ", the newline keeps
+      // matches from spanning both.
+      E.TextOff = Pool.size();
+      Pool += ' ';
+      AppendNormalized(Status.Name, Pool);
+      Pool += "\n ";
+      AppendNormalized(Status.Message, Pool);
+      E.TextLen = Pool.size() - E.TextOff;
+
+      GetTrigrams(Index.getText(E), Trigrams);
+      E.Trigrams = Trigrams.size();
+      const uint32_t Ix = Index.entries.size();
+      for (uint32_t Trigram : Trigrams)
+        Pairs.push_back((uint64_t(Trigram) << 32) | Ix);
+      Index.entries.push_back(E);
+    }
+  }
+
+  sort(Pairs);
+  Index.postings.reserve(Pairs.size());
+  for (uint64_t Pair : Pairs) {
+    const uint32_t Trigram = Pair >> 32;
+    if (Index.keys.empty() || Index.keys.back() != Trigram) {
+      Index.keys.push_back(Trigram);
+      Index.starts.push_back(Index.postings.size());
+    }
+    Index.postings.push_back(uint32_t(Pair));
+  }
+  Index.starts.push_back(Index.postings.size());
+  return Index;
+}
+
+Expected<TrigramIndex> TrigramIndex::load(MemoryBufferRef MBRef) {
+  StringRef Buf = MBRef.getBuffer();
+  if (!Buf.consume_front(IndexMagic))
+    return MakeIndexError("bad magic");
+
+  bool Truncated = false;
+  auto Read32 = [&Buf, &Truncated] () -> uint32_t {
+    if (Buf.size() < 4) {
+      Truncated = true;
+      return 0;
+    }
+    const uint32_t V = support::endian::read32le(Buf.data());
+    Buf = Buf.drop_front(4);
+    return V;
+  };
+  auto ReadArray = [&Read32] (SmallVectorImpl<uint32_t>& Out, size_t N) {
+    Out.reserve(N);
+    for (size_t Ix = 0; Ix < N; ++Ix)
+      Out.push_back(Read32());
+  };
+
+  if (Read32() != IndexVersion)
+    return MakeIndexError("unsupported version");
+  TrigramIndex Index;
+  Index.inputHash = Read32();
+  Index.inputHash |= uint64_t(Read32()) << 32;
+  const uint32_t NEntries  = Read32();
+  const uint32_t NKeys     = Read32();
+  const uint32_t NPostings = Read32();
+  const uint32_t NPool     = Read32();
+  // Cheap sanity check before allocating anything.
+  const uint64_t Needed = (uint64_t(NEntries) * 8 + NKeys * 2ull
+    + 1 + NPostings) * 4 + NPool;
+  if (Truncated || Buf.size() != Needed)
+    return MakeIndexError("size mismatch");
+
+  Index.entries.reserve(NEntries);
+  for (uint32_t Ix = 0; Ix < NEntries; ++Ix) {
+    Entry E;
+    E.ID = Read32();
+    E.NameOff = Read32(), E.NameLen = Read32();
+    E.MsgOff  = Read32(), E.MsgLen  = Read32();
+    E.TextOff = Read32(), E.TextLen = Read32();
+    E.Trigrams = Read32();
+    for (auto [Off, Len] : {std::pair{E.NameOff, E.NameLen},
+        {E.MsgOff, E.MsgLen}, {E.TextOff, E.TextLen}}) {
+      if (uint64_t(Off) + Len > NPool)
+        return MakeIndexError("string out of bounds");
+    }
+    Index.entries.push_back(E);
+  }
+  ReadArray(Index.keys, NKeys);
+  ReadArray(Index.starts, NKeys + 1);
+  ReadArray(Index.postings, NPostings);
+  Index.pool = Buf.str();
+
+  if (!is_sorted(Index.starts) || Index.starts.back() != NPostings)
+    return MakeIndexError("bad posting offsets");
+  if (any_of(Index.postings, [=] (uint32_t Ix) { return Ix >= NEntries; }))
+    return MakeIndexError("posting out of bounds");
+  return Index;
+}
+
+TrigramIndex::HitVec TrigramIndex::find(
+ StringRef Text, size_t MaxHits) const {
+  std::string Normal = " ";
+  AppendNormalized(Text, Normal);
+  const StringRef Query = StringRef(Normal).trim(' ');
+  if (Query.empty())
+    return {};
+
+  HitVec Hits;
+  auto Accept = [&, this] (uint32_t Ix) {
+    if (getText(entries[Ix]).contains(Query))
+      Hits.push_back(getHit(Ix));
+    return !MaxHits || Hits.size() < MaxHits;
+  };
+
+  SmallVector<uint32_t, 64> Trigrams;
+  GetTrigrams(Query, Trigrams);
+  if (Trigrams.empty()) {
+    // Too short to have trigrams, just scan everything.
+    for (uint32_t Ix = 0; Ix < entries.size(); ++Ix) {
+      if (!Accept(Ix))
+        break;
+    }
+    return Hits;
+  }
+
+  // Intersect the rarest lists first, so the candidates shrink fast.
+  SmallVector<ArrayRef<uint32_t>, 64> Lists;
+  for (uint32_t Trigram : Trigrams) {
+    ArrayRef<uint32_t> List = getPostings(Trigram);
+    if (List.empty())
+      return {};
+    Lists.push_back(List);
+  }
+  sort(Lists, [] (ArrayRef<uint32_t> L, ArrayRef<uint32_t> R) {
+    return L.size() < R.size();
+  });
+
+  SmallVector<uint32_t, 0> Candidates(
+    Lists.front().begin(), Lists.front().end());
+  SmallVector<uint32_t, 0> Next;
+  for (ArrayRef<uint32_t> List : makeArrayRef(Lists).drop_front()) {
+    Next.clear();
+    std::set_intersection(Candidates.begin(), Candidates.end(),
+      List.begin(), List.end(), std::back_inserter(Next));
+    Candidates.swap(Next);
+    if (Candidates.empty())
+      break;
+  }
+
+  // Trigrams can match out of order, so confirm each candidate.
+  for (uint32_t Ix : Candidates) {
+    if (!Accept(Ix))
+      break;
+  }
+  return Hits;
+}
+
+TrigramIndex::HitVec TrigramIndex::fuzzy(
+ StringRef Text, size_t MaxHits, double MinScore) const {
+  // Keep the padding, so matching word boundaries counts for more.
+  std::string Normal = " ";
+  AppendNormalized(Text, Normal);
+  SmallVector<uint32_t, 64> Trigrams;
+  GetTrigrams(Normal, Trigrams);
+  if (Trigrams.empty())
+    return {};
+
+  SmallVector<uint32_t, 0> Counts(entries.size(), 0);
+  for (uint32_t Trigram : Trigrams) {
+    for (uint32_t Ix : getPostings(Trigram))
+      ++Counts[Ix];
+  }
+
+  struct Ranked {
+    uint32_t Ix;
+    double   Score;
+    /// Dice coefficient, prefers entries about as long as the query.
+    double   Similarity;
+  };
+  SmallVector<Ranked, 0> Ranking;
+  const double NQuery = Trigrams.size();
+  for (uint32_t Ix = 0; Ix < entries.size(); ++Ix) {
+    const double Score = Counts[Ix] / NQuery;
+    if (Counts[Ix] == 0 || Score < MinScore)
+      continue;
+    const double Similarity = 2.0 * Counts[Ix]
+      / (NQuery + entries[Ix].Trigrams);
+    Ranking.push_back({Ix, Score, Similarity});
+  }
+
+  std::stable_sort(Ranking.begin(), Ranking.end(),
+   [] (const Ranked& L, const Ranked& R) {
+    if (L.Score != R.Score)
+      return L.Score > R.Score;
+    return L.Similarity > R.Similarity;
+  });
+  if (MaxHits && Ranking.size() > MaxHits)
+    Ranking.truncate(MaxHits);
+
+  HitVec Hits;
+  for (const Ranked& R : Ranking)
+    Hits.push_back(getHit(R.Ix, R.Score));
+  return Hits;
+}
+
+void TrigramIndex::serialize(raw_ostream& OS) const {
+  support::endian::Writer W(OS, support::little);
+  OS << IndexMagic;
+  W.write(IndexVersion);
+  W.write(inputHash);
+  W.write(uint32_t(entries.size()));
+  W.write(uint32_t(keys.size()));
+  W.write(uint32_t(postings.size()));
+  W.write(uint32_t(pool.size()));
+  for (const Entry& E : entries) {
+    W.write(E.ID);
+    W.write(E.NameOff), W.write(E.NameLen);
+    W.write(E.MsgOff),  W.write(E.MsgLen);
+    W.write(E.TextOff), W.write(E.TextLen);
+    W.write(E.Trigrams);
+  }
+  W.write(makeArrayRef(keys));
+  W.write(makeArrayRef(starts));
+  W.write(makeArrayRef(postings));
+  OS << pool;
+}
+
+Error TrigramIndex::writeToFile(StringRef Filename) const {
+  SmallString<0> Data;
+  raw_svector_ostream OS {Data};
+  serialize(OS);
+
+  SmallString<128> TempModel = Filename;
+  TempModel += "-%%%%%%%%.tmp";
+  if (Error E = writeFileAtomically(TempModel, Filename, Data)) {
+    return createStringError(inconvertibleErrorCode(),
+      "Error writing \"" + Filename + "\": " + toString(std::move(E)));
+  }
+  return Error::success();
+}
+
+SearchHit TrigramIndex::getHit(uint32_t Ix, double Score) const {
+  const Entry& E = entries[Ix];
+  const StringRef Pool = this->pool;
+  return SearchHit {
+    .ID = E.ID,
+    .Name = Pool.substr(E.NameOff, E.NameLen),
+    .Message = Pool.substr(E.MsgOff, E.MsgLen),
+    .Score = Score
+  };
+}
+
+ArrayRef<uint32_t> TrigramIndex::getPostings(uint32_t Trigram) const {
+  auto It = llvm::lower_bound(keys, Trigram);
+  if (It == keys.end() || *It != Trigram)
+    return {};
+  const size_t Ix = It - keys.begin();
+  return makeArrayRef(postings).slice(starts[Ix], starts[Ix + 1] - starts[Ix]);
+}
+
+//=== Statics ===//
+
+void AppendNormalized(StringRef In, std::string& Out) {
+  // Expects `Out` to end in a space, and leaves it that way.
+  bool InWord = false;
+  for (size_t Ix = 0; Ix < In.size(); ++Ix) {
+    char C = In[Ix];
+    if (C == '&') {
+      // Entities like `&nbsp;` separate words.
+      const size_t End = In.find(';', Ix);
+      if (End != StringRef::npos && End - Ix <= 8) {
+        Ix = End;
+        C = ' ';
+      }
+    }
+    if (isAlnum(C)) {
+      Out.push_back(toLower(C));
+      InWord = true;
+    } else if (InWord) {
+      Out.push_back(' ');
+      InWord = false;
+    }
+  }
+  if (InWord)
+    Out.push_back(' ');
+}
+
+void GetTrigrams(StringRef Text, SmallVectorImpl<uint32_t>& Out) {
+  Out.clear();
+  for (size_t Ix = 0; Ix + 3 <= Text.size(); ++Ix) {
+    Out.push_back((uint32_t(uint8_t(Text[Ix])) << 16)
+      | (uint32_t(uint8_t(Text[Ix + 1])) << 8)
+      | uint32_t(uint8_t(Text[Ix + 2])));
+  }
+  sort(Out);
+  Out.erase(std::unique(Out.begin(), Out.end()), Out.end());
+}
+
+Error MakeIndexError(const Twine& Msg) {
+  return createStringError(inconvertibleErrorCode(),
+    "Invalid trigram index: " + Msg + ".");
+}
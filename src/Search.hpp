@@ -0,0 +1,91 @@
+//===- Search.hpp ---------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Trigram index over the names and messages of a `Catalog`, for going
+// from (part of) a message back to its code.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "NtCode.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Error.h"
+#include <string>
+
+namespace ntcode {
+
+struct SearchHit {
+  uint32_t  ID;
+  StringRef Name;
+  StringRef Message;
+  /// Fraction of the query's trigrams found in the entry.
+  double    Score = 1.0;
+};
+
+/// Names and messages are normalized to lowercase words before
+/// indexing, so queries ignore case, punctuation and underscores.
+/// The index owns its strings, so it outlives the parsed buffer.
+class TrigramIndex {
+  struct Entry {
+    uint32_t ID;
+    uint32_t NameOff, NameLen;
+    uint32_t MsgOff, MsgLen;
+    uint32_t TextOff, TextLen;
+    uint32_t Trigrams;
+  };
+  TrigramIndex() = default;
+public:
+  using HitVec = llvm::SmallVector<SearchHit, 0>;
+  /// `InputHash` identifies the input, so a stale index can be spotted.
+  static TrigramIndex build(const Catalog& C, uint64_t InputHash = 0);
+  static llvm::Expected<TrigramIndex> load(llvm::MemoryBufferRef MBRef);
+
+  /// Entries containing `Text`, in catalog order.
+  HitVec find(StringRef Text, size_t MaxHits = 0) const;
+  /// Entries sharing at least `MinScore` of `Text`'s trigrams,
+  /// best matches first.
+  HitVec fuzzy(StringRef Text, size_t MaxHits = 10,
+    double MinScore = 0.5) const;
+
+  void serialize(llvm::raw_ostream& OS) const;
+  llvm::Error writeToFile(StringRef Filename) const;
+
+  [[nodiscard]] uint64_t getInputHash() const { return this->inputHash; }
+  [[nodiscard]] size_t size() const { return this->entries.size(); }
+
+private:
+  SearchHit getHit(uint32_t Ix, double Score = 1.0) const;
+  StringRef getText(const Entry& E) const {
+    return StringRef(pool).substr(E.TextOff, E.TextLen);
+  }
+  llvm::ArrayRef<uint32_t> getPostings(uint32_t Trigram) const;
+
+private:
+  uint64_t inputHash = 0;
+  llvm::SmallVector<Entry, 0> entries;
+  /// Sorted trigrams, and where each one's postings start.
+  llvm::SmallVector<uint32_t, 0> keys;
+  llvm::SmallVector<uint32_t, 0> starts;
+  /// Entry indices, ascending for each trigram.
+  llvm::SmallVector<uint32_t, 0> postings;
+  /// Display names, messages and normalized text.
+  std::string pool;
+};
+
+} // namespace ntcode
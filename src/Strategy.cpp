@@ -0,0 +1,171 @@
+//===- Strategy.cpp -------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "Strategy.hpp"
+#include "llvm/Support/MathExtras.h"
+
+using namespace llvm;
+
+/// Rough cost of touching a new cache line, in bytes of footprint.
+static constexpr double ProbeWeight = 16.0;
+/// Density at which compilers lower a `switch` to a jump table.
+static constexpr double JumpTableDensity = 0.4;
+
+static unsigned LogProbes(size_t Count);
+
+double StrategyCost::score() const {
+  return double(Bytes) + ProbeWeight * Probes;
+}
+
+StringRef strategy::GetName(EmitStrategy S) {
+  switch (S) {
+   case EmitStrategy::Auto:   return "auto";
+   case EmitStrategy::Switch: return "switch";
+   case EmitStrategy::Dense:  return "dense";
+   case EmitStrategy::Sorted: return "sorted";
+   case EmitStrategy::Hashed: return "hashed";
+  }
+  return "unknown";
+}
+
+unsigned strategy::GetIndexSize(size_t Count) {
+  // Dense tables store `Ix + 1`, so leave room for the empty marker.
+  if (Count < 0xFF)
+    return 1;
+  return (Count < 0xFFFF) ? 2 : 4;
+}
+
+StringRef strategy::GetIndexType(size_t Count) {
+  switch (GetIndexSize(Count)) {
+   case 1:  return "uint8_t";
+   case 2:  return "uint16_t";
+   default: return "uint32_t";
+  }
+}
+
+CodeDistribution strategy::Measure(ArrayRef<uint32_t> Keys) {
+  CodeDistribution Dist;
+  if (Keys.empty())
+    return Dist;
+  Dist.Count = Keys.size();
+  Dist.Min = Dist.Max = Keys.front();
+  for (uint32_t Key : Keys.drop_front()) {
+    Dist.Min = std::min(Dist.Min, Key);
+    Dist.Max = std::max(Dist.Max, Key);
+  }
+  return Dist;
+}
+
+HashLayout strategy::BuildHashLayout(ArrayRef<uint32_t> Keys) {
+  HashLayout Layout;
+  const uint64_t Capacity = PowerOf2Ceil(std::max<size_t>(Keys.size() * 2, 2));
+  const uint32_t Mask = Capacity - 1;
+  Layout.Shift = 32 - Log2_64(Capacity);
+  Layout.Slots.assign(Capacity, HashLayout::Empty);
+
+  uint64_t TotalProbes = 0;
+  for (uint32_t Ix = 0; Ix < Keys.size(); ++Ix) {
+    uint32_t Slot = HashLayout::Hash(Keys[Ix], Layout.Shift);
+    unsigned Probes = 1;
+    while (Layout.Slots[Slot] != HashLayout::Empty) {
+      Slot = (Slot + 1) & Mask;
+      ++Probes;
+    }
+    Layout.Slots[Slot] = Ix;
+    Layout.MaxProbes = std::max(Layout.MaxProbes, Probes);
+    TotalProbes += Probes;
+  }
+
+  if (!Keys.empty())
+    Layout.AvgProbes = double(TotalProbes) / Keys.size();
+  return Layout;
+}
+
+std::optional<StrategyCost> strategy::Estimate(
+ EmitStrategy S, ArrayRef<uint32_t> Keys) {
+  const CodeDistribution Dist = Measure(Keys);
+  const unsigned IxSize = GetIndexSize(Dist.Count);
+  StrategyCost Cost {.Kind = S};
+  if (Dist.Count == 0)
+    return std::nullopt;
+
+  switch (S) {
+   case EmitStrategy::Switch: {
+    if (Dist.Count >= 4 && Dist.density() >= JumpTableDensity) {
+      // Jump table plus one `return` per case.
+      Cost.Bytes = Dist.span() * 4 + Dist.Count * 8;
+      Cost.Probes = Cost.MaxProbes = 1;
+    } else {
+      // Compare tree.
+      Cost.Bytes = Dist.Count * 12;
+      Cost.Probes = Cost.MaxProbes = LogProbes(Dist.Count);
+    }
+    break;
+   }
+   case EmitStrategy::Dense: {
+    if (Dist.span() > MaxDenseSpan)
+      return std::nullopt;
+    Cost.Bytes = Dist.span() * IxSize;
+    Cost.Probes = Cost.MaxProbes = 1;
+    break;
+   }
+   case EmitStrategy::Sorted: {
+    Cost.Bytes = Dist.Count * (sizeof(uint32_t) + IxSize);
+    Cost.Probes = Cost.MaxProbes = LogProbes(Dist.Count);
+    break;
+   }
+   case EmitStrategy::Hashed: {
+    const HashLayout Layout = BuildHashLayout(Keys);
+    Cost.Bytes = Layout.capacity() * (sizeof(uint32_t) + IxSize);
+    Cost.Probes = Layout.AvgProbes;
+    Cost.MaxProbes = Layout.MaxProbes;
+    break;
+   }
+   default:
+    return std::nullopt;
+  }
+
+  return Cost;
+}
+
+StrategyCost strategy::Choose(
+ ArrayRef<uint32_t> Keys, EmitStrategy Override) {
+  if (Override != EmitStrategy::Auto) {
+    if (auto Cost = Estimate(Override, Keys))
+      return *Cost;
+  }
+
+  // Switch is the fallback; it can represent anything.
+  StrategyCost Best = Estimate(EmitStrategy::Switch, Keys)
+    .value_or(StrategyCost{});
+  for (EmitStrategy S : {
+      EmitStrategy::Dense,
+      EmitStrategy::Sorted,
+      EmitStrategy::Hashed}) {
+    auto Cost = Estimate(S, Keys);
+    if (Cost && Cost->score() < Best.score())
+      Best = *Cost;
+  }
+  return Best;
+}
+
+//=== Statics ===//
+
+unsigned LogProbes(size_t Count) {
+  return Log2_64_Ceil(Count + 1);
+}
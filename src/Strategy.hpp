@@ -0,0 +1,90 @@
+//===- Strategy.hpp -------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+#include <optional>
+
+using llvm::StringRef;
+
+/// How a single table (a group, or a facility in a large group)
+/// resolves an `OpqErrorID` to its entry.
+enum class EmitStrategy : uint8_t {
+  Auto,     // Let the cost model decide.
+  Switch,   // One `case` per code.
+  Dense,    // Index array covering [Min, Max].
+  Sorted,   // Binary search over a sorted key array.
+  Hashed,   // Open addressing with linear probing.
+};
+
+struct CodeDistribution {
+  size_t   Count = 0;
+  uint32_t Min = 0;
+  uint32_t Max = 0;
+public:
+  uint64_t span() const { return Count ? (uint64_t(Max) - Min + 1) : 0; }
+  double density() const { return Count ? double(Count) / span() : 0.0; }
+};
+
+struct StrategyCost {
+  EmitStrategy Kind = EmitStrategy::Switch;
+  uint64_t Bytes = 0;
+  double   Probes = 0.0;
+  unsigned MaxProbes = 0;
+public:
+  double score() const;
+};
+
+/// Layout of a hashed table, shared by the estimator and the emitter
+/// so the reported probe counts are the ones the output will have.
+struct HashLayout {
+  static constexpr uint32_t Empty = 0xFFFFFFFF;
+  /// Maps slot -> index into the key array, or `Empty`.
+  llvm::SmallVector<uint32_t, 0> Slots;
+  unsigned Shift = 0;
+  unsigned MaxProbes = 0;
+  double   AvgProbes = 0.0;
+public:
+  static uint32_t Hash(uint32_t Key, unsigned Shift) {
+    return (Key * 0x9E3779B1u) >> Shift;
+  }
+  size_t capacity() const { return Slots.size(); }
+};
+
+namespace strategy {
+  /// Largest span the dense strategy will cover.
+  inline constexpr uint64_t MaxDenseSpan = 1 << 16;
+
+  StringRef GetName(EmitStrategy S);
+  /// Bytes used per stored table index for `Count` entries.
+  unsigned GetIndexSize(size_t Count);
+  StringRef GetIndexType(size_t Count);
+
+  CodeDistribution Measure(llvm::ArrayRef<uint32_t> Keys);
+  HashLayout BuildHashLayout(llvm::ArrayRef<uint32_t> Keys);
+  /// Returns `std::nullopt` when `S` can't represent `Keys`.
+  std::optional<StrategyCost> Estimate(EmitStrategy S,
+    llvm::ArrayRef<uint32_t> Keys);
+  /// Picks the cheapest strategy, or `Override` if it's feasible.
+  StrategyCost Choose(llvm::ArrayRef<uint32_t> Keys,
+    EmitStrategy Override = EmitStrategy::Auto);
+} // namespace strategy
@@ -0,0 +1,88 @@
+//===- Watch.cpp ----------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "Watch.hpp"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/Path.h"
+
+#ifdef __linux__
+# include <sys/inotify.h>
+# include <unistd.h>
+#endif
+
+using namespace llvm;
+
+#ifdef __linux__
+
+static Error MakeErrnoError(const Twine& Msg);
+
+Error ntcode::WatchFile(StringRef Path, function_ref<bool()> OnChange) {
+  SmallString<128> Dir = sys::path::parent_path(Path);
+  if (Dir.empty())
+    Dir = ".";
+  const StringRef Filename = sys::path::filename(Path);
+
+  const int FD = inotify_init1(IN_CLOEXEC);
+  if (FD < 0)
+    return MakeErrnoError("inotify_init1 failed");
+  auto Close = make_scope_exit([FD] { ::close(FD); });
+
+  constexpr uint32_t Mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+  if (inotify_add_watch(FD, Dir.c_str(), Mask) < 0)
+    return MakeErrnoError("Couldn't watch \"" + Dir + "\"");
+
+  alignas(inotify_event) char Events[4096];
+  while (true) {
+    ssize_t Size;
+    do {
+      Size = ::read(FD, Events, sizeof(Events));
+    } while (Size < 0 && errno == EINTR);
+    if (Size <= 0)
+      return MakeErrnoError("Reading inotify events failed");
+
+    // Editors tend to touch the file several times per save,
+    // so one batch of events is one change.
+    bool Changed = false;
+    for (ssize_t Off = 0; Off < Size;) {
+      const auto* Event = reinterpret_cast<const inotify_event*>(Events + Off);
+      if (Event->len && StringRef(Event->name) == Filename)
+        Changed = true;
+      Off += sizeof(inotify_event) + Event->len;
+    }
+
+    if (Changed && !OnChange())
+      return Error::success();
+  }
+}
+
+Error MakeErrnoError(const Twine& Msg) {
+  const int Errno = errno;
+  return createStringError(std::error_code(Errno, std::generic_category()),
+    Msg + ": " + sys::StrError(Errno));
+}
+
+#else
+
+Error ntcode::WatchFile(StringRef, function_ref<bool()>) {
+  return createStringError(inconvertibleErrorCode(),
+    "Watch mode needs inotify, which is only available on Linux.");
+}
+
+#endif
@@ -0,0 +1,33 @@
+//===- Watch.hpp ----------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+
+namespace ntcode {
+
+/// Calls `OnChange` each time `Path` is written or replaced, until it
+/// returns false. The parent directory is watched, so editors that
+/// save through a rename are picked up. Only supported on Linux.
+llvm::Error WatchFile(llvm::StringRef Path,
+  llvm::function_ref<bool()> OnChange);
+
+} // namespace ntcode
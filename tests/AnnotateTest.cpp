@@ -0,0 +1,138 @@
+//===- AnnotateTest.cpp ---------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks which tokens of a log are annotated, and with what, and that
+// files read in chunks are annotated like one string.
+//
+//===----------------------------------------------------------------===//
+
+#include "Annotate.hpp"
+#include "TestSupport.hpp"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include <iterator>
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+/// What `annotateFile` reads at a time.
+static constexpr size_t ChunkSize = size_t(4) << 20;
+
+static std::string MakeLog();
+static void TestAnnotateFile(const LogAnnotator& A);
+
+int main(int N, char* Argv[]) {
+  if (N != 2) {
+    WithColor::error() << "usage: " << Argv[0] << " <input html>\n";
+    return 2;
+  }
+  const auto Input = ReadFile(Argv[1]);
+  const Catalog C = ParseOrExit(Input->getMemBufferRef());
+  const LogAnnotator Names(C);
+  CHECK(Names.lookup(0xC0000022) == " (ACCESS_DENIED)");
+  CHECK(Names.lookup(0xDEADBEEF).empty());
+  CHECK(Names.lookup(0x10000000).empty());
+
+  std::string Out;
+  Names.annotate("failed: 0xC0000022, 0xc0000034 0x0000000012 "
+    "x0xC0000022 0XC000000D 0xDEADBEEF\n", Out);
+  CHECK(Out == "failed: 0xC0000022 (ACCESS_DENIED), "
+    "0xc0000034 (OBJECT_NAME_NOT_FOUND) 0x0000000012 "
+    "x0xC0000022 0XC000000D (INVALID_PARAMETER) 0xDEADBEEF\n");
+
+  // Messages are kept on the annotated line.
+  const LogAnnotator Messages(C, true);
+  Out.clear();
+  Messages.annotate("0xC0000034\n", Out);
+  CHECK(Out == "0xC0000034 (OBJECT_NAME_NOT_FOUND: "
+    "The object name is not found.)\n");
+
+  TestAnnotateFile(Names);
+  TestAnnotateFile(Messages);
+  return Finish();
+}
+
+//=== Statics ===//
+
+std::string MakeLog() {
+  static constexpr StringLiteral Tokens[] {
+    "0xC0000022", "0xc0000034", "0XC000000D", "0xDEADBEEF",
+    "0x0000000012", "x0xC0000022", "0x00000000",
+  };
+  // Lines of varying length, so tokens and lines straddle the ends
+  // of chunks. One line is longer than a chunk, and the last one has
+  // no newline.
+  std::string Log;
+  uint32_t Seed = 1;
+  bool HasLongLine = false;
+  while (Log.size() < 2 * ChunkSize + ChunkSize / 2) {
+    Seed = Seed * 1103515245 + 12345;
+    Log += "pid ";
+    Log += utostr(Seed >> 20);
+    Log += ": failed with ";
+    Log += Tokens[(Seed >> 8) % std::size(Tokens)];
+    Log.append((Seed >> 4) % 96, '.');
+    Log += '\n';
+    if (!HasLongLine && Log.size() > ChunkSize / 2) {
+      Log.append(ChunkSize + 7, '-');
+      Log += " 0xC0000022\n";
+      HasLongLine = true;
+    }
+  }
+  Log += "last 0xC0000034";
+  return Log;
+}
+
+void TestAnnotateFile(const LogAnnotator& A) {
+  const std::string Log = MakeLog();
+  std::string Whole;
+  A.annotate(Log, Whole);
+  CHECK(Whole.size() > Log.size());
+
+  int FD = -1;
+  SmallString<128> Path;
+  if (std::error_code EC =
+      sys::fs::createTemporaryFile("annotate", "log", FD, Path)) {
+    WithColor::error() << "Could not create a log: " << EC.message() << "\n";
+    ++Failures;
+    return;
+  }
+  {
+    raw_fd_ostream OS(FD, true);
+    OS << Log;
+  }
+
+  // Chunks are annotated concurrently, but written in order.
+  for (unsigned Threads : {1u, 4u}) {
+    Expected<sys::fs::file_t> In = sys::fs::openNativeFileForRead(Path);
+    CHECK(bool(In));
+    if (!In) {
+      consumeError(In.takeError());
+      continue;
+    }
+    std::string Out;
+    raw_string_ostream OS(Out);
+    CHECK(!errorToBool(A.annotateFile(*In, OS, Threads)));
+    sys::fs::closeFile(*In);
+    OS.flush();
+    CHECK(Out == Whole);
+  }
+  sys::fs::remove(Path);
+}
@@ -0,0 +1,52 @@
+# Converts inputs with one `-batch` run, and checks each output matches
+# converting that input alone. A missing input fails the run without
+# stopping the other conversions. Inputs are separated by `|`.
+#   cmake -DPARSER=<exe> -DINPUTS=<html>|... -DWORK=<dir> -P Batch.cmake
+string(REPLACE "|" ";" INPUTS "${INPUTS}")
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+
+# Comments and blank lines in the list are skipped.
+set(List "# <input html> <output>\n")
+set(Ix 0)
+foreach(Input ${INPUTS})
+  string(APPEND List "${Input} ${WORK}/batch-${Ix}\n\n")
+  math(EXPR Ix "${Ix} + 1")
+endforeach()
+string(APPEND List "${WORK}/missing.html ${WORK}/batch-missing\n")
+file(WRITE ${WORK}/list.txt ${List})
+
+execute_process(
+  COMMAND ${PARSER} -batch=${WORK}/list.txt -j=4
+  OUTPUT_VARIABLE Output
+  ERROR_VARIABLE Errors
+  RESULT_VARIABLE Result
+)
+if(Result EQUAL 0)
+  message(FATAL_ERROR "-batch succeeded with a missing input.")
+endif()
+if(NOT Errors MATCHES "missing.html")
+  message(FATAL_ERROR "-batch didn't report the missing input:\n${Errors}")
+endif()
+
+set(Ix 0)
+foreach(Input ${INPUTS})
+  execute_process(
+    COMMAND ${PARSER} ${Input} ${WORK}/single-${Ix}
+    OUTPUT_QUIET
+    ERROR_VARIABLE Errors
+    RESULT_VARIABLE Result
+  )
+  if(NOT Result EQUAL 0)
+    message(FATAL_ERROR "${PARSER} failed on ${Input}:\n${Errors}")
+  endif()
+  execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files
+      ${WORK}/batch-${Ix}.cpp ${WORK}/single-${Ix}.cpp
+    RESULT_VARIABLE Result
+  )
+  if(NOT Result EQUAL 0)
+    message(FATAL_ERROR "-batch converted ${Input} differently.")
+  endif()
+  math(EXPR Ix "${Ix} + 1")
+endforeach()
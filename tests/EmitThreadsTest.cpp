@@ -0,0 +1,79 @@
+//===- EmitThreadsTest.cpp ------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks that rendering groups on several threads emits the same bytes
+// as rendering them on one, whatever the settings.
+//
+//===----------------------------------------------------------------===//
+
+#include "Profile.hpp"
+#include "TestSupport.hpp"
+#include "llvm/ADT/SmallVector.h"
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+static void CheckSameOutput(MemoryBufferRef Input, ParserOptions Opts);
+
+int main(int N, char* Argv[]) {
+  if (N != 3) {
+    WithColor::error() << "usage: " << Argv[0]
+      << " <input html> <profile>\n";
+    return 2;
+  }
+  const auto Input = ReadFile(Argv[1]);
+  const auto ProfileMB = ReadFile(Argv[2]);
+  auto EProfile = HitProfile::parse(ProfileMB->getMemBufferRef());
+  if (!EProfile) {
+    WithColor::error() << toString(EProfile.takeError()) << "\n";
+    return 2;
+  }
+
+  SmallVector<ParserOptions, 0> Settings;
+  // Facilities of large groups are rendered as pieces of their own.
+  Settings.emplace_back();
+  Settings.emplace_back().LargeGroupSize = SIZE_MAX;
+  for (EmitStrategy S : {EmitStrategy::Switch, EmitStrategy::Dense,
+       EmitStrategy::Sorted, EmitStrategy::Hashed})
+    Settings.emplace_back().StrategyOverride = S;
+  Settings.emplace_back().EmitRegistry = true;
+  Settings.emplace_back().setHitProfile(std::move(*EProfile));
+  for (EmitMode Mode : {EmitMode::Data, EmitMode::Split})
+    Settings.emplace_back().Mode = Mode;
+
+  for (const ParserOptions& Opts : Settings)
+    CheckSameOutput(Input->getMemBufferRef(), Opts);
+  return Finish();
+}
+
+//=== Statics ===//
+
+void CheckSameOutput(MemoryBufferRef Input, ParserOptions Opts) {
+  Opts.EmitThreads = 1;
+  Catalog Serial = ParseOrExit(Input, Opts);
+  const std::string Expected = Emit(Serial);
+  CHECK(!Expected.empty());
+
+  // Each run gets a catalog of its own, so nothing rendered is reused.
+  for (unsigned Threads : {2u, 4u, 4u}) {
+    Opts.EmitThreads = Threads;
+    Catalog Parallel = ParseOrExit(Input, Opts);
+    CHECK(Emit(Parallel) == Expected);
+  }
+}
@@ -0,0 +1,54 @@
+//===- OptionsTest.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks that emission settings belong to each catalog, and can be
+// changed between emits.
+//
+//===----------------------------------------------------------------===//
+
+#include "TestSupport.hpp"
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+int main(int N, char* Argv[]) {
+  if (N != 2) {
+    WithColor::error() << "usage: " << Argv[0] << " <input html>\n";
+    return 2;
+  }
+  const auto Input = ReadFile(Argv[1]);
+
+  // Settings belong to each catalog, not to the process.
+  ParserOptions DataOpts;
+  DataOpts.Mode = EmitMode::Data;
+  Catalog Code = ParseOrExit(Input->getMemBufferRef());
+  Catalog Data = ParseOrExit(Input->getMemBufferRef(), DataOpts);
+  const std::string CodeOut = Emit(Code);
+  const std::string DataOut = Emit(Data);
+  CHECK(StringRef(DataOut).contains("struct $Catalog"));
+  CHECK(!StringRef(CodeOut).contains("struct $Catalog"));
+  CHECK(Emit(Code) == CodeOut);
+
+  ParserOptions Registry = Code.getParser().getOptions();
+  Registry.EmitRegistry = true;
+  Code.getParser().setOptions(Registry);
+  CHECK(StringRef(Emit(Code)).contains("RegisterFacility"));
+
+  return Finish();
+}
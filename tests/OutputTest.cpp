@@ -0,0 +1,119 @@
+//===- OutputTest.cpp -----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks that outputs are only replaced when their contents change, so
+// their mtime only moves when dependents have to be rebuilt.
+//
+//===----------------------------------------------------------------===//
+
+#include "TestSupport.hpp"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+static sys::TimePoint<> GetMTime(const Twine& Path);
+static void SetMTime(const Twine& Path, sys::TimePoint<> Time);
+static size_t CountFiles(const Twine& Dir);
+
+int main(int N, char* Argv[]) {
+  if (N != 2) {
+    WithColor::error() << "usage: " << Argv[0] << " <input html>\n";
+    return 2;
+  }
+  const auto Input = ReadFile(Argv[1]);
+  SmallString<128> Dir;
+  if (std::error_code EC = sys::fs::createUniqueDirectory("ntcode", Dir)) {
+    WithColor::error() << "Could not create a directory: "
+      << EC.message() << "\n";
+    return 2;
+  }
+  SmallString<128> Base = Dir;
+  sys::path::append(Base, "Output");
+  const std::string Cpp = (Base + ".cpp").str();
+  const std::string Hpp = (Base + ".hpp").str();
+  // Well before any write, so a rewrite always moves it.
+  const sys::TimePoint<> Old = sys::toTimePoint(std::time_t(1000000000));
+
+  ParserOptions Opts;
+  Opts.Mode = EmitMode::Split;
+  Catalog C = ParseOrExit(Input->getMemBufferRef(), Opts);
+  CHECK(!errorToBool(C.writeToFile(Base)));
+  CHECK(sys::fs::exists(Cpp));
+  CHECK(sys::fs::exists(Hpp));
+  SetMTime(Cpp, Old);
+  SetMTime(Hpp, Old);
+
+  // Nothing changed, so neither file is touched.
+  CHECK(!errorToBool(C.writeToFile(Base)));
+  CHECK(GetMTime(Cpp) == Old);
+  CHECK(GetMTime(Hpp) == Old);
+
+  // Only what changed is replaced, and no temporary is left behind.
+  Opts.EmitRegistry = true;
+  C.getParser().setOptions(Opts);
+  CHECK(!errorToBool(C.writeToFile(Base)));
+  CHECK(GetMTime(Cpp) != Old);
+  CHECK(GetMTime(Hpp) == Old);
+  CHECK(CountFiles(Dir) == 2);
+
+  sys::fs::remove_directories(Dir);
+  return Finish();
+}
+
+//=== Statics ===//
+
+sys::TimePoint<> GetMTime(const Twine& Path) {
+  sys::fs::file_status Status;
+  if (std::error_code EC = sys::fs::status(Path, Status)) {
+    WithColor::error() << "Could not stat " << Path << ": "
+      << EC.message() << "\n";
+    ++Failures;
+    return {};
+  }
+  return Status.getLastModificationTime();
+}
+
+void SetMTime(const Twine& Path, sys::TimePoint<> Time) {
+  int FD = -1;
+  std::error_code EC = sys::fs::openFileForWrite(Path, FD,
+    sys::fs::CD_OpenExisting, sys::fs::OF_Append);
+  if (!EC) {
+    EC = sys::fs::setLastAccessAndModificationTime(FD, Time);
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  }
+  if (EC) {
+    WithColor::error() << "Could not set the mtime of " << Path
+      << ": " << EC.message() << "\n";
+    ++Failures;
+  }
+}
+
+size_t CountFiles(const Twine& Dir) {
+  size_t Count = 0;
+  std::error_code EC;
+  for (sys::fs::directory_iterator It(Dir, EC), End; It != End && !EC;
+       It.increment(EC))
+    ++Count;
+  return Count;
+}
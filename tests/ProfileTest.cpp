@@ -0,0 +1,70 @@
+//===- ProfileTest.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks that lookup profiles parse, and that only their entries in
+// the catalog make it to the hot set.
+//
+//===----------------------------------------------------------------===//
+
+#include "Profile.hpp"
+#include "TestSupport.hpp"
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+int main(int N, char* Argv[]) {
+  if (N != 3) {
+    WithColor::error() << "usage: " << Argv[0]
+      << " <input html> <profile>\n";
+    return 2;
+  }
+  const auto Input = ReadFile(Argv[1]);
+  const auto ProfileMB = ReadFile(Argv[2]);
+  auto EProfile = HitProfile::parse(ProfileMB->getMemBufferRef());
+  CHECK(bool(EProfile));
+  if (!EProfile) {
+    consumeError(EProfile.takeError());
+    return Finish();
+  }
+  CHECK(EProfile->lookup(0xC0000022, "ACCESS_DENIED") == 150000);
+  CHECK(EProfile->lookup(0xC0000034, "OBJECT_NAME_NOT_FOUND") == 90000);
+  CHECK(EProfile->lookup(0x00000001, "WAIT_1") == 0);
+
+  const auto Bad = MemoryBuffer::getMemBuffer("0xC0000022\n", "bad");
+  const auto BadCount = MemoryBuffer::getMemBuffer("0xZZ 12\n", "bad");
+  CHECK(errorToBool(HitProfile::parse(*Bad).takeError()));
+  CHECK(errorToBool(HitProfile::parse(*BadCount).takeError()));
+
+  // Only entries that are in the catalog make it to the hot set.
+  ParserOptions Opts;
+  Opts.setHitProfile(std::move(*EProfile));
+  Catalog C = ParseOrExit(Input->getMemBufferRef(), Opts);
+  const std::string Out = Emit(C);
+  CHECK(StringRef(Out).contains("struct $Hot"));
+  CHECK(StringRef(Out).contains("0xC0000022"));
+  CHECK(!StringRef(Out).contains("0xC0FFFFFF"));
+  CHECK(!StringRef(Out).contains("0x1000BEEF"));
+
+  // No hits at all means no hot path.
+  Opts.setHitProfile(HitProfile());
+  C.getParser().setOptions(Opts);
+  CHECK(!StringRef(Emit(C)).contains("struct $Hot"));
+
+  return Finish();
+}
@@ -0,0 +1,121 @@
+//===- ReparseTest.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks that reparsing an edited input only parses the rows around
+// the edit, and ends up where a fresh parse does.
+//
+//===----------------------------------------------------------------===//
+
+#include "TestSupport.hpp"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+static void CheckSameGroups(const Catalog& L, const Catalog& R);
+
+int main(int N, char* Argv[]) {
+  if (N != 2) {
+    WithColor::error() << "usage: " << Argv[0] << " <input html>\n";
+    return 2;
+  }
+  const auto InputMB = ReadFile(Argv[1]);
+  const MemoryBufferRef Input = InputMB->getMemBufferRef();
+  Catalog C = ParseOrExit(Input);
+  const size_t Errors = C.getGroup(StatusGroup::ERROR).size();
+  CHECK(Errors != 0);
+
+  // The same bytes in another buffer reuse every row.
+  const auto Copy = MemoryBuffer::getMemBufferCopy(Input.getBuffer());
+  CHECK(!errorToBool(C.reparse(Copy->getMemBufferRef())));
+  const auto [NoneParsed, Cached] = C.getParser().getRowStats();
+  CHECK(NoneParsed == 0);
+  CHECK(C.getGroup(StatusGroup::ERROR).size() == Errors);
+  CHECK(C.getGroup(StatusGroup::ERROR)[0].Name.data()
+    >= Copy->getBufferStart());
+
+  // An edited message is parsed again, the other rows are reused.
+  // Rows that didn't parse, like the header, aren't cached.
+  const StringRef Old = "The object name is not found.";
+  const size_t At = Input.getBuffer().find(Old);
+  CHECK(At != StringRef::npos);
+  std::string Edited = Input.getBuffer().str();
+  Edited.replace(At, Old.size(), "The object name isn't there.");
+  const auto EditedMB = MemoryBuffer::getMemBuffer(Edited);
+  CHECK(!errorToBool(C.reparse(EditedMB->getMemBufferRef())));
+  CHECK(C.getParser().getRowStats().second + 1 == Cached);
+  CHECK(any_of(C.getGroup(StatusGroup::ERROR), [] (const NtStatus& S) {
+    return S.Message == "The object name isn't there.";
+  }));
+  CHECK(C.getGroup(StatusGroup::ERROR).size() == Errors);
+
+  // Added, removed and renumbered rows end up where a fresh parse
+  // puts them, without parsing the rows around them again.
+  SmallVector<std::unique_ptr<MemoryBuffer>, 4> Buffers;
+  auto Reparse = [&] (std::string Text) {
+    Buffers.push_back(MemoryBuffer::getMemBufferCopy(Text));
+    CHECK(!errorToBool(C.reparse(Buffers.back()->getMemBufferRef())));
+    Catalog Fresh = ParseOrExit(Buffers.back()->getMemBufferRef());
+    CheckSameGroups(C, Fresh);
+    CHECK(Emit(C) == Emit(Fresh));
+    return C.getParser().getRowStats().first;
+  };
+  const size_t Row = Edited.find("<tr>", Edited.size() / 2);
+  const size_t RowEnd = Edited.find("</tr>", Row) + 5;
+  CHECK(Row != std::string::npos && RowEnd > Row);
+  std::string Text = Edited;
+  Text.insert(Row, "<tr><td><p>0xC0010FFE</p><p>STATUS_ADDED</p></td>"
+    "<td><p>Added.</p></td></tr>");
+  Emit(C);
+  CHECK(Reparse(Text) == 1);
+  CHECK(C.getGroup(StatusGroup::ERROR).size() == Errors + 1);
+  // Only the edited group is rendered again.
+  CHECK(C.getParser().getLastEmitted() == ArrayRef<StringRef>("Error"));
+  Text = Edited;
+  Text.erase(Row, RowEnd - Row);
+  CHECK(Reparse(Text) <= 1);
+  Text = Edited;
+  const size_t Code = Text.find("<p>0x", Row) + 5;
+  Text.replace(Code, 8, "C0010FFD");
+  CHECK(Reparse(Text) == 1);
+  // A code that's already there is a duplicate, dropped in full parses.
+  Text.insert(Row, Text.substr(Row, RowEnd - Row));
+  Reparse(Text);
+  Text.erase(Row, RowEnd - Row);
+  Reparse(Text);
+  return Finish();
+}
+
+//=== Statics ===//
+
+void CheckSameGroups(const Catalog& L, const Catalog& R) {
+  using enum StatusGroup;
+  for (StatusGroup G : {SUCCESS, INFO, WARNING, ERROR}) {
+    const StatusSpan LS = L.getGroup(G);
+    const StatusSpan RS = R.getGroup(G);
+    CHECK(LS.keys() == RS.keys());
+    if (LS.size() != RS.size())
+      continue;
+    for (size_t Ix = 0; Ix < LS.size(); ++Ix) {
+      CHECK(LS[Ix].Name == RS[Ix].Name);
+      CHECK(LS[Ix].Message == RS[Ix].Message);
+    }
+  }
+}
@@ -0,0 +1,117 @@
+//===- ReportTest.cpp -----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks the JSON footprint report: its shape, its order, and that its
+// entry counts add up to the catalog in every mode.
+//
+//===----------------------------------------------------------------===//
+
+#include "TestSupport.hpp"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/JSON.h"
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+static void CheckReport(MemoryBufferRef Input, EmitMode Mode);
+
+int main(int N, char* Argv[]) {
+  if (N != 2) {
+    WithColor::error() << "usage: " << Argv[0] << " <input html>\n";
+    return 2;
+  }
+  const auto Input = ReadFile(Argv[1]);
+  for (EmitMode Mode : {EmitMode::Code, EmitMode::Data, EmitMode::Split})
+    CheckReport(Input->getMemBufferRef(), Mode);
+  return Finish();
+}
+
+//=== Statics ===//
+
+void CheckReport(MemoryBufferRef Input, EmitMode Mode) {
+  using enum StatusGroup;
+  ParserOptions Opts;
+  Opts.Mode = Mode;
+  Catalog C = ParseOrExit(Input, Opts);
+  std::string Out;
+  raw_string_ostream OS(Out);
+  C.getParser().dumpFootprint(OS, ReportFormat::JSON);
+  OS.flush();
+
+  Expected<json::Value> EReport = json::parse(Out);
+  CHECK(bool(EReport));
+  if (!EReport) {
+    consumeError(EReport.takeError());
+    return;
+  }
+  const json::Array* Rows = EReport->getAsArray();
+  CHECK(Rows && !Rows->empty());
+  if (!Rows)
+    return;
+
+  // Group rows are named after the group, facility rows add `.<SG>`.
+  const bool Split = (Mode == EmitMode::Split);
+  StringMap<int64_t> GroupEntries, FacilityEntries;
+  int64_t LastSize = INT64_MAX;
+  for (const json::Value& Value : *Rows) {
+    const json::Object* Row = Value.getAsObject();
+    CHECK(Row != nullptr);
+    if (!Row)
+      continue;
+    int64_t Size = 0;
+    for (StringRef Key : {"entries", "switch_cases", "table_bytes",
+         "string_bytes", "unique_string_bytes", "cold_bytes"}) {
+      const Optional<int64_t> Field = Row->getInteger(Key);
+      if (Key == "cold_bytes" && !Split) {
+        CHECK(!Field);
+        continue;
+      }
+      CHECK(Field && *Field >= 0);
+      if (Field && (Key == "table_bytes" ||
+          Key == "unique_string_bytes" || Key == "cold_bytes"))
+        Size += *Field;
+    }
+    // Largest first.
+    CHECK(Size <= LastSize);
+    LastSize = Size;
+
+    const Optional<StringRef> Name = Row->getString("name");
+    CHECK(bool(Name));
+    const Optional<int64_t> Entries = Row->getInteger("entries");
+    if (!Name || !Entries)
+      continue;
+    const auto [Group, SG] = Name->split('.');
+    if (SG.empty())
+      GroupEntries[Group] += *Entries;
+    else
+      FacilityEntries[Group] += *Entries;
+  }
+
+  for (auto [G, Name] : {std::pair(SUCCESS, "Success"),
+       std::pair(INFO, "Info"), std::pair(WARNING, "Warning"),
+       std::pair(ERROR, "Error")}) {
+    const auto Size = int64_t(C.getGroup(G).size());
+    CHECK(GroupEntries.lookup(Name) == Size);
+    // Only code mode has tables per facility.
+    if (Mode == EmitMode::Code)
+      CHECK(FacilityEntries.lookup(Name) == Size);
+    else
+      CHECK(FacilityEntries.lookup(Name) == 0);
+  }
+}
@@ -0,0 +1,264 @@
+//===- RoundTrip.cpp ------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Linked with one generated source, and run on the catalog it was
+// generated from. Every entry has to be found with its name and
+// severity, through single and batched lookups, and nothing else.
+//
+//===----------------------------------------------------------------===//
+
+#include <Sys/OpaqueError.hpp>
+#include "NtCode.hpp"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/WithColor.h"
+#include <vector>
+#if NTCODE_TEST_SPLIT
+# include NTCODE_TEST_HEADER
+#endif
+
+using namespace llvm;
+using namespace hc;
+using namespace hc::sys;
+
+namespace {
+struct CatalogEntry {
+  uint32_t ID;
+  std::string Name;
+  ErrorSeverity Severity;
+};
+} // namespace `anonymous`
+
+static unsigned Failures = 0;
+
+#define CHECK(...) do {                                   \
+  if (!(__VA_ARGS__)) {                                   \
+    WithColor::error() << __FILE__ << ':' << __LINE__     \
+      << ": check failed: " #__VA_ARGS__ "\n";            \
+    ++Failures;                                           \
+  }                                                       \
+} while (0)
+
+static std::string Normalize(StringRef Name);
+static std::vector<CatalogEntry> LoadCatalog(StringRef Filename);
+static std::vector<uint32_t> MakeMisses(ArrayRef<CatalogEntry> Entries);
+static void CheckLookups(ArrayRef<CatalogEntry> Entries,
+  ArrayRef<uint32_t> Misses);
+static void CheckBatch(ArrayRef<CatalogEntry> Entries,
+  ArrayRef<uint32_t> Misses);
+static void CheckRegistry(ArrayRef<CatalogEntry> Entries);
+static void CheckNames(ArrayRef<CatalogEntry> Entries,
+  ArrayRef<uint32_t> Misses);
+
+int main(int N, char* Argv[]) {
+  if (N != 2) {
+    WithColor::error() << "usage: " << Argv[0] << " <input html>\n";
+    return 2;
+  }
+  const std::vector<CatalogEntry> Entries = LoadCatalog(Argv[1]);
+  const std::vector<uint32_t> Misses = MakeMisses(Entries);
+  CheckLookups(Entries, Misses);
+  CheckBatch(Entries, Misses);
+  CheckRegistry(Entries);
+  CheckNames(Entries, Misses);
+
+  outs() << Entries.size() << " entries, " << Misses.size()
+    << " misses, " << Failures << " failures.\n";
+  return Failures ? 1 : 0;
+}
+
+//=== Statics ===//
+
+std::string Normalize(StringRef Name) {
+  // Generated names are PascalCase, the catalog's are SHOUTING_CASE.
+  std::string Out;
+  for (char C : Name) {
+    if (C != '_')
+      Out.push_back(toLower(C));
+  }
+  return Out;
+}
+
+std::vector<CatalogEntry> LoadCatalog(StringRef Filename) {
+  using enum StatusGroup;
+  static std::unique_ptr<MemoryBuffer> MB;
+  auto EMBuffer = MemoryBuffer::getFile(Filename, true);
+  if (!EMBuffer) {
+    WithColor::error() << "Could not open " << Filename << ".\n";
+    exit(2);
+  }
+  MB = std::move(*EMBuffer);
+  auto ECatalog = ntcode::Catalog::parse(MB->getMemBufferRef());
+  if (!ECatalog) {
+    WithColor::error() << toString(ECatalog.takeError()) << "\n";
+    exit(2);
+  }
+
+  std::vector<CatalogEntry> Entries;
+  for (StatusGroup G : {SUCCESS, INFO, WARNING, ERROR}) {
+    const StatusSpan Statuses = ECatalog->getGroup(G);
+    for (size_t Ix = 0; Ix < Statuses.size(); ++Ix) {
+      Entries.push_back({
+        .ID = (uint32_t(G) << (7 * 4)) | Statuses.keys()[Ix],
+        .Name = Normalize(Statuses[Ix].Name),
+        .Severity = ErrorSeverity(uint32_t(G) >> 2)
+      });
+    }
+  }
+  return Entries;
+}
+
+std::vector<uint32_t> MakeMisses(ArrayRef<CatalogEntry> Entries) {
+  std::vector<uint32_t> Known;
+  for (const CatalogEntry& E : Entries)
+    Known.push_back(E.ID);
+  llvm::sort(Known);
+
+  // Invalid severities, unknown facilities and the neighbours of
+  // every entry, which land in the same tables and hash slots.
+  std::vector<uint32_t> Misses {
+    0x10000000, 0x20000022, 0x3FFFFFFF, 0x7FFFFFFF,
+    0xC0FFF000, 0xC0FFFFFF, 0xDEADBEEF, 0xFFFFFFFE,
+  };
+  for (const CatalogEntry& E : Entries) {
+    for (uint32_t ID : {E.ID + 1, E.ID - 1, E.ID ^ 0x10000000,
+                        E.ID ^ 0x00800000, E.ID | 0x0000F000}) {
+      if (!std::binary_search(Known.begin(), Known.end(), ID))
+        Misses.push_back(ID);
+    }
+  }
+  return Misses;
+}
+
+void CheckLookups(ArrayRef<CatalogEntry> Entries,
+ ArrayRef<uint32_t> Misses) {
+  for (const CatalogEntry& E : Entries) {
+    OpaqueError Err = SysErr::GetOpaqueError(E.ID);
+    CHECK(Err != nullptr);
+    if (!Err)
+      continue;
+    // Facility prefixes like `Dbg` are only in the generated name.
+    CHECK(StringRef(Normalize(Err->name)).endswith(E.Name));
+    CHECK(Err->msg != nullptr);
+    // Messages spanning lines are joined, whatever the line endings.
+    if (Err->msg)
+      CHECK(StringRef(Err->msg).find_first_of("\r\n") == StringRef::npos);
+    CHECK(Err->g == ErrorGroup::OSError);
+    CHECK(Err->extra.severity == E.Severity);
+    // Entries are shared, not built per call.
+    CHECK(SysErr::GetOpaqueError(E.ID) == Err);
+  }
+  for (uint32_t ID : Misses)
+    CHECK(SysErr::GetOpaqueError(ID) == nullptr);
+}
+
+void CheckBatch(ArrayRef<CatalogEntry> Entries,
+ ArrayRef<uint32_t> Misses) {
+  // Hits and misses interleaved, over several batch blocks.
+  std::vector<OpqErrorID> IDs;
+  for (size_t Ix = 0; Ix < std::max(Entries.size(), Misses.size()); ++Ix) {
+    if (Ix < Entries.size())
+      IDs.push_back(Entries[Entries.size() - Ix - 1].ID);
+    if (Ix < Misses.size())
+      IDs.push_back(Misses[Ix]);
+  }
+
+  // One slot more than the lookups, which has to be left alone.
+  const auto Sentinel = reinterpret_cast<OpaqueError>(&IDs);
+  std::vector<OpaqueError> Out(IDs.size() + 1, Sentinel);
+  SysErr::GetOpaqueErrorBatch(IDs, Out);
+  for (size_t Ix = 0; Ix < IDs.size(); ++Ix)
+    CHECK(Out[Ix] == SysErr::GetOpaqueError(IDs[Ix]));
+  CHECK(Out.back() == Sentinel);
+
+  // Extra IDs past the end of `Out` are ignored.
+  if (IDs.size() > 1) {
+    std::fill(Out.begin(), Out.end(), Sentinel);
+    SysErr::GetOpaqueErrorBatch(IDs, std::span(Out).first(IDs.size() / 2));
+    CHECK(Out[IDs.size() / 2] == Sentinel);
+  }
+  SysErr::GetOpaqueErrorBatch({}, Out);
+}
+
+void CheckRegistry(ArrayRef<CatalogEntry> Entries) {
+#if NTCODE_TEST_REGISTRY
+  static constexpr uint32_t Codes[] {0x001, 0x005, 0x0FF};
+  static constexpr IOpaqueError Table[] {
+    $NewOpqErr(ErrorGroup::OSError, "One", "First.",
+      OpqErrorExtra {.severity = ErrorSeverity::Error}),
+    $NewOpqErr(ErrorGroup::OSError, "Five", "Second.",
+      OpqErrorExtra {.severity = ErrorSeverity::Error}),
+    $NewOpqErr(ErrorGroup::OSError, "Last", "Third.",
+      OpqErrorExtra {.severity = ErrorSeverity::Error}),
+  };
+  static constexpr uint32_t Unsorted[] {0x005, 0x001, 0x0FF};
+  static constexpr uint32_t TooLarge[] {0x001, 0x005, 0x1000};
+
+  // Facility 0xABC isn't in the catalog.
+  constexpr OpqErrorID Prefix = 0xC0ABC000;
+  CHECK(!SysErr::RegisterFacility(Prefix | 1, Codes, Table));
+  CHECK(!SysErr::RegisterFacility(Prefix, Unsorted, Table));
+  CHECK(!SysErr::RegisterFacility(Prefix, TooLarge, Table));
+  CHECK(!SysErr::RegisterFacility(Prefix,
+    std::span(Codes).first(2), Table));
+  CHECK(SysErr::GetOpaqueError(Prefix | 0x001) == nullptr);
+
+  CHECK(SysErr::RegisterFacility(Prefix, Codes, Table));
+  for (size_t Ix = 0; Ix < std::size(Codes); ++Ix)
+    CHECK(SysErr::GetOpaqueError(Prefix | Codes[Ix]) == &Table[Ix]);
+  CHECK(SysErr::GetOpaqueError(Prefix | 0x002) == nullptr);
+  CHECK(SysErr::GetOpaqueError(0x40ABC001) == nullptr);
+
+  const OpqErrorID IDs[] {Prefix | 0x0FF, 0xDEADBEEF, Prefix | 0x001};
+  OpaqueError Out[std::size(IDs)] {};
+  SysErr::GetOpaqueErrorBatch(IDs, Out);
+  CHECK(Out[0] == &Table[2]);
+  CHECK(Out[1] == nullptr);
+  CHECK(Out[2] == &Table[0]);
+
+  // The catalog's own entries win over registered ones.
+  if (!Entries.empty()) {
+    const uint32_t ID = Entries.front().ID;
+    static uint32_t Shadow[1];
+    Shadow[0] = ID & 0xFFF;
+    CHECK(SysErr::RegisterFacility(ID & ~0xFFFu, Shadow,
+      std::span(Table).first(1)));
+    CHECK(SysErr::GetOpaqueError(ID) != &Table[0]);
+  }
+#else
+  (void)Entries;
+#endif
+}
+
+void CheckNames(ArrayRef<CatalogEntry> Entries,
+ ArrayRef<uint32_t> Misses) {
+#if NTCODE_TEST_SPLIT
+  for (const CatalogEntry& E : Entries) {
+    const char* Name = GetOpaqueErrorName(E.ID);
+    CHECK(Name != nullptr);
+    if (Name)
+      CHECK(StringRef(Normalize(Name)).endswith(E.Name));
+  }
+  for (uint32_t ID : Misses)
+    CHECK(GetOpaqueErrorName(ID) == nullptr);
+#else
+  (void)Entries;
+  (void)Misses;
+#endif
+}
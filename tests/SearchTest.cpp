@@ -0,0 +1,70 @@
+//===- SearchTest.cpp -----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Checks the trigram index: exact and fuzzy searches, and that a
+// serialized index loads back unless it was damaged.
+//
+//===----------------------------------------------------------------===//
+
+#include "Search.hpp"
+#include "TestSupport.hpp"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+
+using namespace llvm;
+using namespace ntcode;
+using namespace ntcode::test;
+
+int main(int N, char* Argv[]) {
+  if (N != 2) {
+    WithColor::error() << "usage: " << Argv[0] << " <input html>\n";
+    return 2;
+  }
+  const auto Input = ReadFile(Argv[1]);
+  const Catalog C = ParseOrExit(Input->getMemBufferRef());
+  const TrigramIndex Index = TrigramIndex::build(C, 42);
+  CHECK(Index.size() > 0);
+  const auto Hits = Index.find("access denied");
+  CHECK(any_of(Hits, [] (const SearchHit& H) {
+    return H.ID == 0xC0000022;
+  }));
+  CHECK(Index.find("no status says this").empty());
+  const auto Fuzzy = Index.fuzzy("acess denid");
+  CHECK(!Fuzzy.empty());
+
+  SmallString<0> Data;
+  raw_svector_ostream OS(Data);
+  Index.serialize(OS);
+  auto ELoaded = TrigramIndex::load(MemoryBufferRef(Data, "index"));
+  CHECK(bool(ELoaded));
+  if (ELoaded) {
+    CHECK(ELoaded->getInputHash() == 42);
+    CHECK(ELoaded->size() == Index.size());
+    CHECK(ELoaded->find("access denied").size() == Hits.size());
+  } else {
+    consumeError(ELoaded.takeError());
+  }
+
+  Data[0] ^= 0xFF;
+  CHECK(errorToBool(
+    TrigramIndex::load(MemoryBufferRef(Data, "index")).takeError()));
+  CHECK(errorToBool(TrigramIndex::load(
+    MemoryBufferRef(StringRef(Data).drop_back(1), "index")).takeError()));
+
+  return Finish();
+}
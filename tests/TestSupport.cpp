@@ -0,0 +1,57 @@
+//===- TestSupport.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "TestSupport.hpp"
+
+using namespace llvm;
+using namespace ntcode;
+
+unsigned test::Failures = 0;
+
+std::unique_ptr<MemoryBuffer> test::ReadFile(StringRef Filename) {
+  auto EMBuffer = MemoryBuffer::getFile(Filename, true);
+  if (!EMBuffer) {
+    WithColor::error() << "Could not open " << Filename << ".\n";
+    exit(2);
+  }
+  return std::move(*EMBuffer);
+}
+
+Catalog test::ParseOrExit(MemoryBufferRef MBRef, ParserOptions Opts) {
+  auto ECatalog = Catalog::parse(MBRef, std::move(Opts));
+  if (!ECatalog) {
+    WithColor::error() << toString(ECatalog.takeError()) << "\n";
+    exit(2);
+  }
+  return std::move(*ECatalog);
+}
+
+std::string test::Emit(Catalog& C) {
+  std::string Out;
+  raw_string_ostream OS(Out);
+  if (Error E = C.emit(OS)) {
+    WithColor::error() << toString(std::move(E)) << "\n";
+    ++Failures;
+  }
+  return Out;
+}
+
+int test::Finish() {
+  outs() << Failures << " failures.\n";
+  return Failures ? 1 : 0;
+}
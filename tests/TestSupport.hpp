@@ -0,0 +1,53 @@
+//===- TestSupport.hpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Shared by the tests of the in-process API. Failed checks are counted
+// rather than fatal, so one run reports all of them.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "NtCode.hpp"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/WithColor.h"
+#include <memory>
+#include <string>
+
+namespace ntcode::test {
+
+extern unsigned Failures;
+
+#define CHECK(...) do {                                   \
+  if (!(__VA_ARGS__)) {                                   \
+    ::llvm::WithColor::error() << __FILE__ << ':'         \
+      << __LINE__ << ": check failed: " #__VA_ARGS__ "\n";\
+    ++::ntcode::test::Failures;                           \
+  }                                                       \
+} while (0)
+
+/// Exits if `Filename` can't be read.
+std::unique_ptr<llvm::MemoryBuffer> ReadFile(StringRef Filename);
+/// Exits if `MBRef` doesn't parse.
+Catalog ParseOrExit(llvm::MemoryBufferRef MBRef, ParserOptions Opts = {});
+/// The generated source, counting a failure if it couldn't be emitted.
+std::string Emit(Catalog& C);
+/// Prints the number of failed checks, and returns the exit code.
+int Finish();
+
+} // namespace ntcode::test
@@ -0,0 +1,69 @@
+//===- Sys/OpaqueError.hpp ------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Stand-in for the runtime's header, with only what generated sources
+// use. Lets the tests compile and run the output of every mode.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace hc {
+
+enum class ErrorGroup : uint8_t {
+  OSError,
+};
+
+enum class ErrorSeverity : uint8_t {
+  Success, Info, Warning, Error,
+};
+
+struct OpqErrorExtra {
+  ErrorSeverity severity;
+};
+
+struct IOpaqueError {
+  ErrorGroup g;
+  const char* name;
+  const char* msg;
+  OpqErrorExtra extra;
+};
+
+#define $NewOpqErr(g, name, msg, extra) \
+  ::hc::IOpaqueError {g, name, msg, extra}
+
+namespace sys {
+
+using OpqErrorID = uint32_t;
+using OpaqueError = const IOpaqueError*;
+
+struct SysErr {
+  static OpaqueError GetOpaqueError(OpqErrorID ID);
+  static void GetOpaqueErrorBatch(
+    std::span<const OpqErrorID> IDs, std::span<OpaqueError> Out);
+  /// Only defined by sources generated with `-emit-registry`.
+  static bool RegisterFacility(OpqErrorID Prefix,
+    std::span<const uint32_t> Codes, std::span<const IOpaqueError> Table);
+};
+
+} // namespace sys
+} // namespace hc